@@ -0,0 +1,234 @@
+// ARP cache learned from observed ARP traffic (header only, just #include it)
+// Every Ethernet/IPv4 ARP frame feeds its sender binding (VLAN, IP) -> MAC into a
+// compact open-addressing table (linear probing, 20-byte slots, no per-frame malloc),
+// and the same lookup classifies the frame in one pass:
+//   gratuitous  : sender IP == target IP (announcement / takeover)
+//   duplicate IP: an IP claimed by another MAC while the cached owner is still active,
+//                 or an address probe (sender IP 0.0.0.0) for an IP that is in use
+//   spoofing    : binding overwritten by an unsolicited reply, or by a frame whose
+//                 Ethernet source differs from the ARP sender MAC
+//   MAC change  : binding moved after the old owner went quiet (NIC swap, DHCP reuse)
+// Entries not refreshed within ARP_AGE_US count as absent and their slots are reused.
+#ifndef ARP_CACHE_H
+#define ARP_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define ARP_CACHE_INIT_SIZE 1024         // must be a power of 2
+#define ARP_AGE_US (300ULL * 1000000)    // entry lifetime without refresh (Linux/Windows ~minutes)
+#define ARP_ACTIVE_US (10ULL * 1000000)  // old owner seen this recently => two hosts claim the IP
+#define ARP_SOLICIT_US (2ULL * 1000000)  // a reply within this time of a request is solicited
+#define ARP_PENDING_SIZE 4096            // direct mapped "who-has" slots, must be a power of 2
+#define ARP_MAX_ALERTS 32                // alerts kept for the exit report
+
+enum arp_verdict { ARP_NEW, ARP_REFRESH, ARP_GRATUITOUS, ARP_MAC_CHANGE, ARP_DUPLICATE_IP, ARP_SPOOF, ARP_IGNORED, ARP_N };
+static const char *arp_verdict_names[ARP_N] = {
+    "New binding", "Refresh", "Gratuitous", "MAC change", "DUPLICATE IP", "SPOOFING SUSPECTED", "Not cached"};
+
+struct arp_entry {
+    uint32_t ip;        // network byte order, 0 = empty slot (0.0.0.0 is never cached)
+    uint16_t vid;       // VLAN the binding was seen on (0 = untagged)
+    uint8_t mac[6];
+    uint32_t last_s;    // last refresh, seconds (aging resolution is plenty)
+    uint16_t changes;   // times the MAC of this IP changed
+    uint16_t pad;
+};
+
+struct arp_pending {
+    uint32_t ip;        // target of the last request hashed into this slot
+    uint16_t vid;
+    uint64_t ts_us;
+};
+
+struct arp_alert {
+    uint64_t ts_us;
+    uint32_t ip;
+    uint16_t vid;
+    uint8_t verdict;
+    uint8_t old_mac[6], new_mac[6];
+};
+
+struct arp_cache {
+    struct arp_entry *slots;
+    uint32_t size;      // power of 2
+    uint32_t used;      // non-empty slots (live + aged)
+    struct arp_pending *pending;
+    uint64_t verdicts[ARP_N];
+    uint64_t frames;
+    uint32_t n_alerts;
+    struct arp_alert alerts[ARP_MAX_ALERTS];
+};
+
+void arp_cache_init(struct arp_cache *c) {
+    memset(c, 0, sizeof(*c));
+    c->size = ARP_CACHE_INIT_SIZE;
+    c->slots = (struct arp_entry *)calloc(c->size, sizeof(struct arp_entry));
+    c->pending = (struct arp_pending *)calloc(ARP_PENDING_SIZE, sizeof(struct arp_pending));
+    if (!c->slots || !c->pending) {
+        perror("arp cache alloc");
+        exit(1);
+    }
+}
+
+void arp_cache_free(struct arp_cache *c) {
+    free(c->slots);
+    free(c->pending);
+    c->slots = NULL;
+    c->pending = NULL;
+}
+
+static inline uint32_t arp_hash(uint32_t ip, uint16_t vid) {
+    uint64_t h = ((uint64_t)vid << 32 | ip) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32);
+}
+
+static inline int arp_live(const struct arp_entry *e, uint64_t now_us) {
+    return e->ip && (uint64_t)e->last_s * 1000000 + ARP_AGE_US > now_us;
+}
+
+// Rebuild keeping only live entries; doubles the table if they still fill half of it
+static void arp_cache_rebuild(struct arp_cache *c, uint64_t now_us) {
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < c->size; i++) live += arp_live(&c->slots[i], now_us);
+    uint32_t new_size = (live * 2 >= c->size) ? c->size * 2 : c->size;
+
+    struct arp_entry *old = c->slots;
+    uint32_t old_size = c->size;
+    c->slots = (struct arp_entry *)calloc(new_size, sizeof(struct arp_entry));
+    if (!c->slots) {
+        perror("arp cache grow");
+        exit(1);
+    }
+    c->size = new_size;
+    c->used = 0;
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (!arp_live(&old[i], now_us)) continue;
+        uint32_t idx = arp_hash(old[i].ip, old[i].vid) & (c->size - 1);
+        while (c->slots[idx].ip) idx = (idx + 1) & (c->size - 1);
+        c->slots[idx] = old[i];
+        c->used++;
+    }
+    free(old);
+}
+
+// Slot holding (ip, vid) if live, otherwise the slot to insert it into
+// (the first aged slot on the probe path, else the empty slot ending it)
+static struct arp_entry *arp_slot(struct arp_cache *c, uint32_t ip, uint16_t vid, uint64_t now_us) {
+    uint32_t idx = arp_hash(ip, vid) & (c->size - 1);
+    struct arp_entry *reuse = NULL;
+    for (;;) {
+        struct arp_entry *e = &c->slots[idx];
+        if (!e->ip) return reuse ? reuse : e;
+        if (e->ip == ip && e->vid == vid) return arp_live(e, now_us) ? e : (reuse ? reuse : e);
+        if (!reuse && !arp_live(e, now_us)) reuse = e;
+        idx = (idx + 1) & (c->size - 1);
+    }
+}
+
+// Live binding for (ip, vid) or NULL
+const struct arp_entry *arp_cache_lookup(struct arp_cache *c, uint32_t ip, uint16_t vid, uint64_t now_us) {
+    struct arp_entry *e = arp_slot(c, ip, vid, now_us);
+    return (e->ip == ip && e->vid == vid && arp_live(e, now_us)) ? e : NULL;
+}
+
+static void arp_alert(struct arp_cache *c, enum arp_verdict v, uint64_t now_us, uint32_t ip, uint16_t vid,
+                      const uint8_t *old_mac, const uint8_t *new_mac) {
+    if (c->n_alerts == ARP_MAX_ALERTS) return;
+    struct arp_alert *a = &c->alerts[c->n_alerts++];
+    a->ts_us = now_us;
+    a->ip = ip;
+    a->vid = vid;
+    a->verdict = v;
+    memcpy(a->old_mac, old_mac, 6);
+    memcpy(a->new_mac, new_mac, 6);
+}
+
+// Feed one ARP frame (Ethernet/IPv4 addresses, IPs in network byte order).
+// 'eth_src' is the frame's source MAC; returns the classification of the frame.
+enum arp_verdict arp_cache_observe(struct arp_cache *c, uint64_t now_us, uint16_t vid, uint16_t op,
+                                   const uint8_t *eth_src, const uint8_t *sha, uint32_t spa, uint32_t tpa) {
+    c->frames++;
+    enum arp_verdict v;
+    uint8_t zero_mac[6] = {0};
+
+    int solicited = 0;
+    if (op == 1) { // remember "who-has tpa" so the reply can be checked for solicitation
+        struct arp_pending *p = &c->pending[arp_hash(tpa, vid) & (ARP_PENDING_SIZE - 1)];
+        p->ip = tpa;
+        p->vid = vid;
+        p->ts_us = now_us;
+    } else { // the first reply consumes the request, a second (racing) answer is unsolicited
+        struct arp_pending *p = &c->pending[arp_hash(spa, vid) & (ARP_PENDING_SIZE - 1)];
+        solicited = (p->ip == spa && p->vid == vid && now_us - p->ts_us <= ARP_SOLICIT_US);
+        if (solicited) p->ip = 0;
+    }
+
+    if (spa == 0) { // address probe (RFC 5227): nothing to learn, but the address may be taken
+        const struct arp_entry *owner = arp_cache_lookup(c, tpa, vid, now_us);
+        v = (owner && memcmp(owner->mac, sha, 6) != 0) ? ARP_DUPLICATE_IP : ARP_IGNORED;
+        if (v == ARP_DUPLICATE_IP) arp_alert(c, v, now_us, tpa, vid, owner->mac, sha);
+        c->verdicts[v]++;
+        return v;
+    }
+
+    if (c->used * 4 >= c->size * 3) arp_cache_rebuild(c, now_us);
+    struct arp_entry *e = arp_slot(c, spa, vid, now_us);
+    int gratuitous = (spa == tpa);
+
+    if (!e->ip || !(e->ip == spa && e->vid == vid && arp_live(e, now_us))) {
+        if (!e->ip) c->used++;
+        e->ip = spa;
+        e->vid = vid;
+        e->changes = 0;
+        memcpy(e->mac, sha, 6);
+        v = gratuitous ? ARP_GRATUITOUS : ARP_NEW;
+        if (gratuitous) arp_alert(c, v, now_us, spa, vid, zero_mac, sha); // host announced itself
+    } else if (memcmp(e->mac, sha, 6) == 0) {
+        v = gratuitous ? ARP_GRATUITOUS : ARP_REFRESH;
+    } else {
+        if (memcmp(eth_src, sha, 6) != 0 || (op == 2 && !solicited)) v = ARP_SPOOF;
+        else if ((uint64_t)e->last_s * 1000000 + ARP_ACTIVE_US > now_us) v = ARP_DUPLICATE_IP;
+        else v = ARP_MAC_CHANGE;
+        arp_alert(c, v, now_us, spa, vid, e->mac, sha);
+        memcpy(e->mac, sha, 6);
+        e->changes++;
+    }
+    e->last_s = (uint32_t)(now_us / 1000000);
+    c->verdicts[v]++;
+    return v;
+}
+
+static void arp_mac_str(const uint8_t *m, char *buf) {
+    sprintf(buf, "%02X:%02X:%02X:%02X:%02X:%02X", m[0], m[1], m[2], m[3], m[4], m[5]);
+}
+
+void arp_cache_report(struct arp_cache *c, uint64_t now_us) {
+    if (!c->frames) return;
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < c->size; i++) live += arp_live(&c->slots[i], now_us);
+    printf("\n[ARP Cache] frames:%llu live bindings:%u slots:%u\n",
+           (unsigned long long)c->frames, live, c->size);
+    for (int v = 0; v < ARP_N; v++)
+        if (c->verdicts[v]) printf("\t|-%-18s : %llu\n", arp_verdict_names[v], (unsigned long long)c->verdicts[v]);
+
+    for (uint32_t i = 0; i < c->n_alerts; i++) {
+        const struct arp_alert *a = &c->alerts[i];
+        char ip[INET_ADDRSTRLEN], old_mac[18], new_mac[18];
+        inet_ntop(AF_INET, &a->ip, ip, sizeof(ip));
+        arp_mac_str(a->old_mac, old_mac);
+        arp_mac_str(a->new_mac, new_mac);
+        if (a->verdict == ARP_GRATUITOUS)
+            printf("\t[%llu.%06llu] %-18s vlan:%-4u %s is-at %s\n", (unsigned long long)(a->ts_us / 1000000),
+                   (unsigned long long)(a->ts_us % 1000000), arp_verdict_names[a->verdict], a->vid, ip, new_mac);
+        else
+            printf("\t[%llu.%06llu] %-18s vlan:%-4u %s %s -> %s\n", (unsigned long long)(a->ts_us / 1000000),
+                   (unsigned long long)(a->ts_us % 1000000), arp_verdict_names[a->verdict], a->vid, ip, old_mac, new_mac);
+    }
+    if (c->n_alerts == ARP_MAX_ALERTS) printf("\t(only the first %d alerts are listed)\n", ARP_MAX_ALERTS);
+}
+
+#endif
@@ -0,0 +1,334 @@
+// Capture statistics for the stats-only mode (header only, just #include it)
+// Aggregates only, nothing is printed per packet: a protocol hierarchy tree (packets and
+// bytes per protocol path, like "tshark -z io,phs"), a packet size histogram, the VLAN
+// distribution, the top talking IP addresses and the capture rates.
+//
+// Every counter of one decoding thread lives in its own shard, aligned to a cache line
+// so shards of different threads never share one; cap_stats_merge() folds shards into
+// the shard that gets reported. The per-packet path is a lean header walk (no printing,
+// no flow/DNS/ARP tracking) so it keeps up with page-cached files at >10 Mpps.
+#ifndef CAPTURE_STATS_H
+#define CAPTURE_STATS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define CS_CACHE_LINE 64
+#define CS_MAX_NODES 128          // protocol paths kept in the hierarchy tree
+#define CS_SIZE_BUCKETS 12        // 0-63, 64-127, 128-255, ... (log2 of the wire length)
+#define CS_IP_INIT_SIZE 1024      // must be a power of 2
+#define CS_TOP_N 10               // VLANs / IPs shown in the report
+
+enum cs_proto { CS_ETH, CS_VLAN, CS_QINQ, CS_ARP, CS_IPV4, CS_IPV6, CS_TCP, CS_UDP, CS_ICMP, CS_IGMP,
+                CS_ICMPV6, CS_FRAG, CS_DNS, CS_OTHER, CS_N_PROTOS };
+static const char *cs_proto_names[CS_N_PROTOS] = {"eth", "vlan", "qinq", "arp", "ipv4", "ipv6", "tcp", "udp",
+                                                  "icmp", "igmp", "icmpv6", "fragment", "dns", "other"};
+
+struct cs_counter {
+    uint64_t packets, bytes;
+};
+
+// Tree node 0 is the root (all frames); child[node][proto] is 0 until that path is seen
+struct cs_node {
+    struct cs_counter cnt;
+    uint8_t parent, proto, depth;
+};
+
+struct cs_ip_entry {
+    uint8_t addr[16];   // v4-mapped for IPv4 (as in flow_table.h)
+    uint64_t packets;   // as source or destination
+    uint64_t bytes;
+};
+
+struct cap_stats {
+    struct cs_node nodes[CS_MAX_NODES];
+    uint8_t child[CS_MAX_NODES][CS_N_PROTOS];
+    uint32_t n_nodes;
+    uint32_t overflow;                        // paths dropped because the tree was full
+    uint64_t sizes[CS_SIZE_BUCKETS];
+    uint64_t vlans[4096];                     // innermost VID, untagged frames are not counted
+    uint64_t first_us, last_us;               // capture timestamps
+    struct cs_ip_entry *ips;
+    uint32_t ip_size, ip_count;
+} __attribute__((aligned(CS_CACHE_LINE)));
+
+void cap_stats_init(struct cap_stats *s) {
+    memset(s, 0, sizeof(*s));
+    s->n_nodes = 1;
+    s->ip_size = CS_IP_INIT_SIZE;
+    s->ips = (struct cs_ip_entry *)calloc(s->ip_size, sizeof(struct cs_ip_entry));
+    if (!s->ips) {
+        perror("capture stats alloc");
+        exit(1);
+    }
+}
+
+void cap_stats_free(struct cap_stats *s) {
+    free(s->ips);
+    s->ips = NULL;
+}
+
+// Node for 'proto' under 'node', created on first use (node 0 = tree full, counted at the parent only)
+static inline uint32_t cs_child(struct cap_stats *s, uint32_t node, enum cs_proto proto) {
+    uint32_t c = s->child[node][proto];
+    if (c) return c;
+    if (s->n_nodes == CS_MAX_NODES) {
+        s->overflow++;
+        return 0;
+    }
+    c = s->n_nodes++;
+    s->nodes[c].parent = (uint8_t)node;
+    s->nodes[c].proto = (uint8_t)proto;
+    s->nodes[c].depth = s->nodes[node].depth + 1;
+    s->child[node][proto] = (uint8_t)c;
+    return c;
+}
+
+static inline uint32_t cs_count(struct cap_stats *s, uint32_t node, enum cs_proto proto, uint32_t bytes) {
+    if (!node && proto != CS_ETH) return 0; // below a dropped path
+    uint32_t c = cs_child(s, node, proto);
+    if (!c) return 0;
+    s->nodes[c].cnt.packets++;
+    s->nodes[c].cnt.bytes += bytes;
+    return c;
+}
+
+static inline uint64_t cs_ip_hash(const uint8_t *addr) {
+    uint64_t w[2];
+    memcpy(w, addr, 16);
+    uint64_t h = (w[0] ^ 0x9E3779B97F4A7C15ULL) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ w[1] ^ (h >> 31)) * 0x94D049BB133111EBULL;
+    return h ^ (h >> 29);
+}
+
+static struct cs_ip_entry *cs_ip_slot(struct cs_ip_entry *slots, uint32_t size, const uint8_t *addr) {
+    uint32_t mask = size - 1, i = (uint32_t)cs_ip_hash(addr) & mask;
+    while (slots[i].packets && memcmp(slots[i].addr, addr, 16) != 0) i = (i + 1) & mask;
+    return &slots[i];
+}
+
+static void cs_ip_add(struct cap_stats *s, const uint8_t *addr, uint64_t packets, uint64_t bytes) {
+    if (s->ip_count * 4 >= s->ip_size * 3) { // keep load <= 75%
+        uint32_t new_size = s->ip_size * 2;
+        struct cs_ip_entry *slots = (struct cs_ip_entry *)calloc(new_size, sizeof(struct cs_ip_entry));
+        if (!slots) {
+            perror("capture stats grow");
+            exit(1);
+        }
+        for (uint32_t i = 0; i < s->ip_size; i++)
+            if (s->ips[i].packets) *cs_ip_slot(slots, new_size, s->ips[i].addr) = s->ips[i];
+        free(s->ips);
+        s->ips = slots;
+        s->ip_size = new_size;
+    }
+    struct cs_ip_entry *e = cs_ip_slot(s->ips, s->ip_size, addr);
+    if (!e->packets) {
+        memcpy(e->addr, addr, 16);
+        s->ip_count++;
+    }
+    e->packets += packets;
+    e->bytes += bytes;
+}
+
+static inline void cs_ip_add_v4(struct cap_stats *s, const uint8_t *ip4, uint32_t bytes) {
+    uint8_t addr[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    memcpy(addr + 12, ip4, 4);
+    cs_ip_add(s, addr, 1, bytes);
+}
+
+// Account one frame; only the captured bytes are looked at, the wire length is counted
+void cap_stats_packet(struct cap_stats *s, uint64_t ts_us, const uint8_t *p, uint32_t caplen, uint32_t wirelen) {
+    if (!s->first_us) s->first_us = ts_us;
+    s->last_us = ts_us;
+    uint32_t b = wirelen < 64 ? 0 : 31 - __builtin_clz(wirelen) - 5;
+    s->sizes[b < CS_SIZE_BUCKETS ? b : CS_SIZE_BUCKETS - 1]++;
+
+    s->nodes[0].cnt.packets++;
+    s->nodes[0].cnt.bytes += wirelen;
+    if (caplen < 14) return;
+    uint32_t node = cs_count(s, 0, CS_ETH, wirelen);
+
+    uint32_t off = 14;
+    uint16_t type = p[12] << 8 | p[13];
+    int tagged = 0;
+    uint16_t vid = 0;
+    while ((type == 0x8100 || type == 0x88a8) && off + 4 <= caplen) {
+        node = cs_count(s, node, type == 0x8100 ? CS_VLAN : CS_QINQ, wirelen);
+        vid = (p[off] << 8 | p[off + 1]) & 0x0FFF;
+        type = p[off + 2] << 8 | p[off + 3];
+        tagged = 1;
+        off += 4;
+    }
+    if (tagged) s->vlans[vid]++;
+
+    uint8_t l4 = 0;
+    int first_fragment = 1;
+    if (type == 0x0800 && off + 20 <= caplen) {
+        node = cs_count(s, node, CS_IPV4, wirelen);
+        const uint8_t *ip = p + off;
+        cs_ip_add_v4(s, ip + 12, wirelen);
+        cs_ip_add_v4(s, ip + 16, wirelen);
+        l4 = ip[9];
+        first_fragment = ((ip[6] & 0x1F) | ip[7]) == 0;
+        off += (ip[0] & 0x0F) * 4;
+    } else if (type == 0x86DD && off + 40 <= caplen) {
+        node = cs_count(s, node, CS_IPV6, wirelen);
+        const uint8_t *ip6 = p + off;
+        cs_ip_add(s, ip6 + 8, 1, wirelen);
+        cs_ip_add(s, ip6 + 24, 1, wirelen);
+        l4 = ip6[6];
+        off += 40;
+        // Skip the extension headers (same set walk_ipv6_ext_headers() knows)
+        for (int i = 0; i < 8 && off + 8 <= caplen; i++) {
+            if (l4 == 44) { // fragment header
+                first_fragment = ((p[off + 2] << 8 | p[off + 3]) & 0xFFF8) == 0;
+                l4 = p[off];
+                off += 8;
+            } else if (l4 == 0 || l4 == 43 || l4 == 60 || l4 == 51) {
+                uint32_t len = (l4 == 51) ? (p[off + 1] + 2) * 4 : (p[off + 1] + 1) * 8;
+                l4 = p[off];
+                off += len;
+            } else {
+                break;
+            }
+        }
+    } else {
+        cs_count(s, node, (type == 0x0806 || type == 0x8035) ? CS_ARP : CS_OTHER, wirelen);
+        return;
+    }
+
+    if (!first_fragment) {
+        cs_count(s, node, CS_FRAG, wirelen);
+        return;
+    }
+    enum cs_proto proto;
+    switch (l4) {
+        case 6: proto = CS_TCP; break;
+        case 17: proto = CS_UDP; break;
+        case 1: proto = CS_ICMP; break;
+        case 2: proto = CS_IGMP; break;
+        case 58: proto = CS_ICMPV6; break;
+        default: proto = CS_OTHER; break;
+    }
+    node = cs_count(s, node, proto, wirelen);
+    if (proto == CS_UDP && off + 4 <= caplen &&
+        ((p[off] << 8 | p[off + 1]) == 53 || (p[off + 2] << 8 | p[off + 3]) == 53))
+        cs_count(s, node, CS_DNS, wirelen);
+}
+
+// Recreate node 'src_node' of 'src' (and its subtree) under 'dst_node' of 'dst'
+static void cs_merge_node(struct cap_stats *dst, uint32_t dst_node, const struct cap_stats *src, uint32_t src_node) {
+    for (int proto = 0; proto < CS_N_PROTOS; proto++) {
+        uint32_t sc = src->child[src_node][proto];
+        if (!sc || (!dst_node && proto != CS_ETH)) continue;
+        uint32_t dc = cs_child(dst, dst_node, (enum cs_proto)proto);
+        if (!dc) continue;
+        dst->nodes[dc].cnt.packets += src->nodes[sc].cnt.packets;
+        dst->nodes[dc].cnt.bytes += src->nodes[sc].cnt.bytes;
+        cs_merge_node(dst, dc, src, sc);
+    }
+}
+
+// Fold another thread's shard into 'dst'
+void cap_stats_merge(struct cap_stats *dst, const struct cap_stats *src) {
+    dst->nodes[0].cnt.packets += src->nodes[0].cnt.packets;
+    dst->nodes[0].cnt.bytes += src->nodes[0].cnt.bytes;
+    cs_merge_node(dst, 0, src, 0);
+    dst->overflow += src->overflow;
+    for (int b = 0; b < CS_SIZE_BUCKETS; b++) dst->sizes[b] += src->sizes[b];
+    for (int v = 0; v < 4096; v++) dst->vlans[v] += src->vlans[v];
+    if (src->first_us && (!dst->first_us || src->first_us < dst->first_us)) dst->first_us = src->first_us;
+    if (src->last_us > dst->last_us) dst->last_us = src->last_us;
+    for (uint32_t i = 0; i < src->ip_size; i++)
+        if (src->ips[i].packets) cs_ip_add(dst, src->ips[i].addr, src->ips[i].packets, src->ips[i].bytes);
+}
+
+static void cs_print_tree(const struct cap_stats *s, uint32_t node) {
+    const struct cs_node *nd = &s->nodes[node];
+    uint64_t total = s->nodes[0].cnt.packets;
+    printf("\t%*s%-*s frames:%-10llu %6.2f%%  bytes:%llu\n", nd->depth * 2, "", 22 - nd->depth * 2,
+           cs_proto_names[nd->proto], (unsigned long long)nd->cnt.packets, 100.0 * nd->cnt.packets / total,
+           (unsigned long long)nd->cnt.bytes);
+    for (int proto = 0; proto < CS_N_PROTOS; proto++)
+        if (s->child[node][proto]) cs_print_tree(s, s->child[node][proto]);
+}
+
+static void cs_format_ip(const uint8_t *addr, char *buf) {
+    static const uint8_t v4_prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (memcmp(addr, v4_prefix, 12) == 0) inet_ntop(AF_INET, addr + 12, buf, INET6_ADDRSTRLEN);
+    else inet_ntop(AF_INET6, addr, buf, INET6_ADDRSTRLEN);
+}
+
+// 'elapsed_s' is the processing wall time, for the processing rate line
+void cap_stats_report(const struct cap_stats *s, double elapsed_s) {
+    const struct cs_counter *all = &s->nodes[0].cnt;
+    if (!all->packets) return;
+    double span_s = (s->last_us - s->first_us) / 1e6;
+    printf("\n[Capture Statistics] frames:%llu bytes:%llu duration:%.3fs\n",
+           (unsigned long long)all->packets, (unsigned long long)all->bytes, span_s);
+    if (span_s > 0)
+        printf("\t|-Capture rate    : %.1f pkts/s, %.3f Mbit/s, avg %.0f bytes/pkt\n", all->packets / span_s,
+               all->bytes * 8 / span_s / 1e6, (double)all->bytes / all->packets);
+    if (elapsed_s > 0)
+        printf("\t|-Processed in    : %.3fs (%.2f Mpps)\n", elapsed_s, all->packets / elapsed_s / 1e6);
+
+    printf("\n[Protocol Hierarchy]\n");
+    for (int proto = 0; proto < CS_N_PROTOS; proto++)
+        if (s->child[0][proto]) cs_print_tree(s, s->child[0][proto]);
+    if (all->packets > s->nodes[s->child[0][CS_ETH]].cnt.packets)
+        printf("\t(truncated frames < 14 bytes: %llu)\n",
+               (unsigned long long)(all->packets - s->nodes[s->child[0][CS_ETH]].cnt.packets));
+    if (s->overflow) printf("\t(%u frames beyond %d protocol paths counted at their parent only)\n", s->overflow, CS_MAX_NODES);
+
+    printf("\n[Packet Sizes]\n");
+    for (int b = 0; b < CS_SIZE_BUCKETS; b++) {
+        if (!s->sizes[b]) continue;
+        if (b == 0) printf("\t|-%5d-%-5d : ", 0, 63);
+        else if (b == CS_SIZE_BUCKETS - 1) printf("\t|-%5d+      : ", 32 << b);
+        else printf("\t|-%5d-%-5d : ", 32 << b, (64 << b) - 1);
+        printf("%-10llu %6.2f%%\n", (unsigned long long)s->sizes[b], 100.0 * s->sizes[b] / all->packets);
+    }
+
+    // Top N by simple selection: N passes over small arrays are cheap at exit
+    uint64_t untagged = all->packets, shown_min = UINT64_MAX;
+    int last_vid = -1;
+    for (int v = 0; v < 4096; v++) untagged -= s->vlans[v];
+    printf("\n[VLANs] untagged:%llu\n", (unsigned long long)untagged);
+    for (int k = 0; k < CS_TOP_N; k++) {
+        int best = -1;
+        for (int v = 0; v < 4096; v++) {
+            if (!s->vlans[v]) continue;
+            // strictly below the previous pick, or equal and after it (stable order for ties)
+            if (s->vlans[v] > shown_min || (s->vlans[v] == shown_min && v <= last_vid)) continue;
+            if (best < 0 || s->vlans[v] > s->vlans[best]) best = v;
+        }
+        if (best < 0) break;
+        printf("\t|-VLAN %-4d : %-10llu %6.2f%%\n", best, (unsigned long long)s->vlans[best],
+               100.0 * s->vlans[best] / all->packets);
+        shown_min = s->vlans[best];
+        last_vid = best;
+    }
+
+    printf("\n[Top IPs] by packets (source or destination), %u addresses\n", s->ip_count);
+    uint32_t top[CS_TOP_N], n_top = 0;
+    for (uint32_t i = 0; i < s->ip_size; i++) {
+        if (!s->ips[i].packets) continue;
+        uint32_t pos = n_top < CS_TOP_N ? n_top++ : CS_TOP_N;
+        while (pos > 0 && s->ips[top[pos - 1]].packets < s->ips[i].packets) {
+            if (pos < CS_TOP_N) top[pos] = top[pos - 1];
+            pos--;
+        }
+        if (pos < CS_TOP_N) top[pos] = i;
+    }
+    for (uint32_t k = 0; k < n_top; k++) {
+        const struct cs_ip_entry *e = &s->ips[top[k]];
+        char ip[INET6_ADDRSTRLEN];
+        cs_format_ip(e->addr, ip);
+        printf("\t|-%-39s packets:%-10llu bytes:%llu\n", ip, (unsigned long long)e->packets, (unsigned long long)e->bytes);
+    }
+}
+
+#endif
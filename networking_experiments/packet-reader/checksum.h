@@ -0,0 +1,122 @@
+// Internet checksum (RFC 1071) verification for the decoders (header only, just #include it)
+// The one's complement sum is byte order independent, so words are summed in host order
+// and a received header/segment is valid when the folded sum (checksum field included,
+// pseudo header added for TCP/UDP/ICMPv6) equals 0xFFFF - no byte swapping needed.
+// 32-bit words are accumulated into 64-bit lanes (carries are folded once at the end),
+// using AVX2 when the CPU has it and a scalar loop otherwise.
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CSUM_HAVE_AVX2 1
+#endif
+
+enum csum_proto { CSUM_IPV4, CSUM_TCP, CSUM_UDP, CSUM_ICMP, CSUM_IGMP, CSUM_ICMPV6, CSUM_N };
+static const char *csum_proto_names[CSUM_N] = {"IPv4", "TCP", "UDP", "ICMP", "IGMP", "ICMPv6"};
+
+struct csum_stats {
+    uint64_t checked[CSUM_N]; // verified (good or bad)
+    uint64_t bad[CSUM_N];     // verification failed
+    uint64_t skipped[CSUM_N]; // not verifiable: fragment, truncated capture, UDP over IPv4 without checksum
+};
+
+// Add 'len' bytes at 'buf' to a running 64-bit sum (odd trailing byte is zero padded)
+static uint64_t csum_add_scalar(const void *buf, size_t len, uint64_t sum) {
+    const uint8_t *p = (const uint8_t *)buf;
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, p, 4);
+        sum += w;
+        p += 4; len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t w;
+        memcpy(&w, p, 2);
+        sum += w;
+        p += 2; len -= 2;
+    }
+    if (len) {
+        uint8_t last[2] = {*p, 0};
+        uint16_t w;
+        memcpy(&w, last, 2);
+        sum += w;
+    }
+    return sum;
+}
+
+#ifdef CSUM_HAVE_AVX2
+__attribute__((target("avx2")))
+static uint64_t csum_add_avx2(const void *buf, size_t len, uint64_t sum) {
+    const uint8_t *p = (const uint8_t *)buf;
+    if (len >= 64) {
+        const __m256i zero = _mm256_setzero_si256();
+        __m256i acc = zero; // 4 x 64-bit lanes, each gets 32-bit words added
+        while (len >= 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)p);
+            acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(v, zero));
+            acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(v, zero));
+            p += 32; len -= 32;
+        }
+        uint64_t lanes[4];
+        _mm256_storeu_si256((__m256i *)lanes, acc);
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    return csum_add_scalar(p, len, sum);
+}
+#endif
+
+static uint64_t csum_add_resolve(const void *buf, size_t len, uint64_t sum);
+static uint64_t (*csum_add)(const void *buf, size_t len, uint64_t sum) = csum_add_resolve;
+
+// First call picks the implementation for this CPU, later calls go straight to it
+static uint64_t csum_add_resolve(const void *buf, size_t len, uint64_t sum) {
+    csum_add = csum_add_scalar;
+#ifdef CSUM_HAVE_AVX2
+    if (__builtin_cpu_supports("avx2")) csum_add = csum_add_avx2;
+#endif
+    return csum_add(buf, len, sum);
+}
+
+static inline uint16_t csum_fold(uint64_t sum) {
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFFFFFF) + (sum >> 32);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)sum;
+}
+
+// Checksum to put into a header (field zeroed beforehand), same result as myping.c's checksum()
+static inline uint16_t csum_compute(const void *buf, size_t len) {
+    return (uint16_t)~csum_fold(csum_add(buf, len, 0));
+}
+
+// Record the verification result of a sum that includes the checksum field
+static inline const char *csum_record(struct csum_stats *st, enum csum_proto p, uint64_t sum) {
+    st->checked[p]++;
+    if (csum_fold(sum) == 0xFFFF) return "(Verified)";
+    st->bad[p]++;
+    return "(BAD CHECKSUM)";
+}
+
+static inline const char *csum_skip(struct csum_stats *st, enum csum_proto p) {
+    st->skipped[p]++;
+    return "(Unverified)";
+}
+
+void csum_report(const struct csum_stats *st) {
+    uint64_t any = 0;
+    for (int p = 0; p < CSUM_N; p++) any += st->checked[p] + st->skipped[p];
+    if (!any) return;
+    printf("\n[Checksum Summary]\n");
+    for (int p = 0; p < CSUM_N; p++)
+        if (st->checked[p] + st->skipped[p])
+            printf("\t|-%-7s checked:%llu bad:%llu unverifiable:%llu\n", csum_proto_names[p],
+                   (unsigned long long)st->checked[p], (unsigned long long)st->bad[p], (unsigned long long)st->skipped[p]);
+}
+
+#endif
@@ -0,0 +1,221 @@
+// Columnar binary output of decoded packet metadata (header only, just #include it)
+// Instead of printf-ing every field, the decoder fills one struct pkt_meta per packet
+// and the writer stores it column-wise in fixed width columns, so later analysis can
+// mmap() the file and scan only the columns it needs without re-parsing the capture.
+//
+// File layout (host byte order, little-endian on x86):
+//   struct col_file_header                         (fixed size, 4KB aligned data start)
+//   row group 0: column 0 [rows * width0] | column 1 [rows * width1] | ...
+//   row group 1: ...
+// Every row group holds rows_per_group rows except the last one (n_rows % rows_per_group),
+// so column c of group g starts at data_offset + g * group_bytes + col_start[c] * rows_in_group(g).
+#ifndef COLUMNAR_OUT_H
+#define COLUMNAR_OUT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define COL_MAGIC "PKTCOL\0\1"
+#define COL_VERSION 1
+#define COL_ROWS_PER_GROUP 65536
+#define COL_DATA_OFFSET 4096 // header is padded so that column data is page aligned
+#define COL_MAX_COLUMNS 32
+
+// One decoded packet; every field maps to one fixed width column
+struct pkt_meta {
+    uint64_t ts_us;       // capture timestamp (microseconds since epoch)
+    uint64_t file_index;  // packet number in the capture (0 based)
+    uint32_t caplen;      // captured bytes
+    uint32_t wirelen;     // original length on the wire
+    uint16_t ethertype;   // innermost EtherType (after VLAN tags)
+    uint16_t outer_vid;   // first VLAN id (0 = untagged)
+    uint16_t inner_vid;   // last VLAN id (same as outer for single tag)
+    uint8_t vlan_count;
+    uint8_t family;       // AF_INET / AF_INET6 / 0 (not IP)
+    uint8_t src[16];      // L3 source (v4-mapped for IPv4, see flow_table.h)
+    uint8_t dst[16];      // L3 destination
+    uint16_t sport;
+    uint16_t dport;
+    uint8_t proto;        // upper layer protocol
+    uint8_t tcp_flags;    // raw TCP flag byte (0 if not TCP)
+    uint8_t ip_flags;     // bit0: more-fragments, bit1: dont-fragment, bit2: non-first fragment
+    uint8_t ttl;          // TTL / hop limit
+    uint16_t l3_offset;   // offsets inside the frame
+    uint16_t l4_offset;
+    uint16_t payload_offset;
+    uint16_t payload_len;
+};
+
+struct col_desc {
+    char name[16];
+    uint32_t width;     // bytes per value
+    uint32_t start;     // sum of widths of the preceding columns
+};
+
+struct col_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t n_columns;
+    uint32_t rows_per_group;
+    uint32_t row_width;   // sum of all column widths
+    uint64_t n_rows;      // written at close
+    uint64_t data_offset; // first row group
+    struct col_desc cols[COL_MAX_COLUMNS];
+};
+
+#define COL_FIELD(f) { #f, sizeof(((struct pkt_meta *)0)->f), offsetof(struct pkt_meta, f) }
+static const struct { const char *name; uint32_t width, offset; } col_fields[] = {
+    COL_FIELD(ts_us), COL_FIELD(file_index), COL_FIELD(caplen), COL_FIELD(wirelen),
+    COL_FIELD(ethertype), COL_FIELD(outer_vid), COL_FIELD(inner_vid), COL_FIELD(vlan_count),
+    COL_FIELD(family), COL_FIELD(src), COL_FIELD(dst), COL_FIELD(sport), COL_FIELD(dport),
+    COL_FIELD(proto), COL_FIELD(tcp_flags), COL_FIELD(ip_flags), COL_FIELD(ttl),
+    COL_FIELD(l3_offset), COL_FIELD(l4_offset), COL_FIELD(payload_offset), COL_FIELD(payload_len),
+};
+#define COL_N_FIELDS (sizeof(col_fields) / sizeof(col_fields[0]))
+
+// --- Writer ---
+
+struct col_writer {
+    int fd;
+    struct col_file_header hdr;
+    uint8_t *group;     // one row group, already in column order
+    uint32_t rows;      // rows buffered in 'group'
+};
+
+// Returns 0 on success, -1 (errno set) on failure
+int col_writer_open(struct col_writer *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0) return -1;
+
+    memcpy(w->hdr.magic, COL_MAGIC, 8);
+    w->hdr.version = COL_VERSION;
+    w->hdr.n_columns = COL_N_FIELDS;
+    w->hdr.rows_per_group = COL_ROWS_PER_GROUP;
+    w->hdr.data_offset = COL_DATA_OFFSET;
+    for (uint32_t c = 0; c < COL_N_FIELDS; c++) {
+        strncpy(w->hdr.cols[c].name, col_fields[c].name, sizeof(w->hdr.cols[c].name) - 1);
+        w->hdr.cols[c].width = col_fields[c].width;
+        w->hdr.cols[c].start = w->hdr.row_width;
+        w->hdr.row_width += col_fields[c].width;
+    }
+    w->group = (uint8_t *)malloc((size_t)w->hdr.row_width * COL_ROWS_PER_GROUP);
+    if (!w->group || lseek(w->fd, COL_DATA_OFFSET, SEEK_SET) < 0) {
+        int err = errno;
+        free(w->group);
+        close(w->fd);
+        w->group = NULL;
+        w->fd = -1;
+        errno = err;
+        return -1;
+    }
+    return 0;
+}
+
+// Write the buffered (possibly partial) row group: one iovec per column
+static int col_flush_group(struct col_writer *w) {
+    if (w->rows == 0) return 0;
+    struct iovec iov[COL_MAX_COLUMNS];
+    size_t total = 0;
+    for (uint32_t c = 0; c < w->hdr.n_columns; c++) {
+        iov[c].iov_base = w->group + (size_t)w->hdr.cols[c].start * COL_ROWS_PER_GROUP;
+        iov[c].iov_len = (size_t)w->hdr.cols[c].width * w->rows;
+        total += iov[c].iov_len;
+    }
+    if (writev(w->fd, iov, w->hdr.n_columns) != (ssize_t)total) return -1;
+    w->hdr.n_rows += w->rows;
+    w->rows = 0;
+    return 0;
+}
+
+int col_write_row(struct col_writer *w, const struct pkt_meta *m) {
+    for (uint32_t c = 0; c < COL_N_FIELDS; c++) {
+        uint32_t width = col_fields[c].width;
+        memcpy(w->group + (size_t)w->hdr.cols[c].start * COL_ROWS_PER_GROUP + (size_t)w->rows * width,
+               (const uint8_t *)m + col_fields[c].offset, width);
+    }
+    if (++w->rows == COL_ROWS_PER_GROUP) return col_flush_group(w);
+    return 0;
+}
+
+int col_writer_close(struct col_writer *w) {
+    int ret = col_flush_group(w);
+    if (pwrite(w->fd, &w->hdr, sizeof(w->hdr), 0) != sizeof(w->hdr)) ret = -1;
+    if (close(w->fd) < 0) ret = -1;
+    free(w->group);
+    return ret;
+}
+
+// --- mmap reader (for downstream analysis) ---
+
+struct col_file {
+    const uint8_t *base;
+    size_t size;
+    const struct col_file_header *hdr;
+};
+
+// Header consistent with itself and with the file size, so that col_value() stays inside the mapping
+static int col_file_valid(const struct col_file *f) {
+    const struct col_file_header *h = f->hdr;
+    if (memcmp(h->magic, COL_MAGIC, 8) != 0 || h->version != COL_VERSION) return 0;
+    if (h->n_columns == 0 || h->n_columns > COL_MAX_COLUMNS || h->rows_per_group == 0) return 0;
+    uint64_t width = 0;
+    for (uint32_t c = 0; c < h->n_columns; c++) {
+        if (h->cols[c].width == 0 || h->cols[c].start != width) return 0;
+        width += h->cols[c].width;
+    }
+    if (width != h->row_width || h->data_offset < sizeof(struct col_file_header) || h->data_offset > f->size) return 0;
+    return h->n_rows <= (f->size - h->data_offset) / width; // n_rows * row_width bytes of data, no overflow
+}
+
+// Returns 0 on success, -1 (errno set) if the file cannot be mapped or is not a valid column file
+int col_file_map(struct col_file *f, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) < 0) { close(fd); return -1; }
+    if ((size_t)st.st_size < sizeof(struct col_file_header)) { close(fd); errno = EINVAL; return -1; }
+    f->size = st.st_size;
+    f->base = (const uint8_t *)mmap(NULL, f->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (f->base == MAP_FAILED) return -1;
+    f->hdr = (const struct col_file_header *)f->base;
+    if (!col_file_valid(f)) {
+        munmap((void *)f->base, f->size);
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+// Column index by name, -1 if absent
+int col_find(const struct col_file *f, const char *name) {
+    for (uint32_t c = 0; c < f->hdr->n_columns; c++)
+        if (strncmp(f->hdr->cols[c].name, name, sizeof(f->hdr->cols[c].name)) == 0) return c;
+    return -1;
+}
+
+// Pointer to value 'row' of column 'col' (columns are contiguous within a row group)
+static inline const void *col_value(const struct col_file *f, int col, uint64_t row) {
+    const struct col_file_header *h = f->hdr;
+    uint64_t g = row / h->rows_per_group, r = row % h->rows_per_group;
+    uint64_t full_groups = h->n_rows / h->rows_per_group;
+    uint64_t rows_in_group = (g < full_groups) ? h->rows_per_group : h->n_rows % h->rows_per_group;
+    return f->base + h->data_offset + g * (uint64_t)h->row_width * h->rows_per_group
+           + (uint64_t)h->cols[col].start * rows_in_group + r * h->cols[col].width;
+}
+
+void col_file_unmap(struct col_file *f) {
+    munmap((void *)f->base, f->size);
+}
+
+#endif
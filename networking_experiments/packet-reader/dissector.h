@@ -0,0 +1,103 @@
+// Protocol dissector registry (header only, just #include it)
+// Every layer dispatches through a dense lookup table instead of a switch / if chain:
+//   EtherType (64K entries), IP protocol (256), UDP port (64K), TCP port (64K)
+// each entry is a 1 byte dissector id into the table's own list, id 0 being the table's
+// default dissector, so dispatch is always two loads and one indirect call no matter
+// how many protocols are registered. Dissectors are registered once at startup.
+//
+// The context passed to the dissectors (struct dissect_ctx) is defined by the decoder
+// that includes this header.
+#ifndef DISSECTOR_H
+#define DISSECTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#define DISSECT_MAX_PER_TABLE 256 // ids are uint8_t
+
+struct dissect_ctx;
+typedef int (*dissect_fn)(struct dissect_ctx *c);
+
+enum dissect_table_id { DISSECT_ETHERTYPE, DISSECT_IP_PROTO, DISSECT_UDP_PORT, DISSECT_TCP_PORT, DISSECT_N_TABLES };
+
+struct dissector {
+    const char *name;
+    dissect_fn fn;
+};
+
+struct dissect_table {
+    const char *name;
+    uint8_t *ids;       // key -> index into 'list'
+    uint32_t size;      // number of keys
+    uint32_t n;         // registered dissectors (list[0] is the default)
+    struct dissector list[DISSECT_MAX_PER_TABLE];
+};
+
+static uint8_t dissect_ids_ethertype[1 << 16], dissect_ids_ip_proto[1 << 8];
+static uint8_t dissect_ids_udp_port[1 << 16], dissect_ids_tcp_port[1 << 16];
+
+static struct dissect_table dissect_tables[DISSECT_N_TABLES] = {
+    {"EtherType", dissect_ids_ethertype, 1 << 16, 1, {{0}}},
+    {"IP Protocol", dissect_ids_ip_proto, 1 << 8, 1, {{0}}},
+    {"UDP Port", dissect_ids_udp_port, 1 << 16, 1, {{0}}},
+    {"TCP Port", dissect_ids_tcp_port, 1 << 16, 1, {{0}}},
+};
+
+static int dissect_nothing(struct dissect_ctx *c) { (void)c; return 0; }
+
+// Dissector used for keys nobody registered
+void dissector_set_default(enum dissect_table_id t, const char *name, dissect_fn fn) {
+    dissect_tables[t].list[0].name = name;
+    dissect_tables[t].list[0].fn = fn;
+}
+
+// Register 'fn' for 'key'; one dissector may serve several keys (same id is reused)
+void dissector_register(enum dissect_table_id t, uint32_t key, const char *name, dissect_fn fn) {
+    struct dissect_table *tab = &dissect_tables[t];
+    if (key >= tab->size) {
+        fprintf(stderr, "Dissector %s: key %u out of range for the %s table\n", name, key, tab->name);
+        exit(1);
+    }
+    uint32_t id = 1;
+    while (id < tab->n && tab->list[id].fn != fn) id++;
+    if (id == tab->n) {
+        if (tab->n == DISSECT_MAX_PER_TABLE) {
+            fprintf(stderr, "Dissector %s: %s table is full\n", name, tab->name);
+            exit(1);
+        }
+        tab->list[id].name = name;
+        tab->list[id].fn = fn;
+        tab->n++;
+    }
+    tab->ids[key] = (uint8_t)id;
+}
+
+// Unregistered defaults do nothing
+void dissector_init(void) {
+    for (int t = 0; t < DISSECT_N_TABLES; t++)
+        if (!dissect_tables[t].list[0].fn) dissector_set_default((enum dissect_table_id)t, "none", dissect_nothing);
+}
+
+static inline int dissect(enum dissect_table_id t, uint32_t key, struct dissect_ctx *c) {
+    const struct dissect_table *tab = &dissect_tables[t];
+    return tab->list[tab->ids[key]].fn(c);
+}
+
+// Port tables: the source port wins if registered, else the destination port decides
+static inline int dissect_ports(enum dissect_table_id t, uint16_t sport, uint16_t dport, struct dissect_ctx *c) {
+    const struct dissect_table *tab = &dissect_tables[t];
+    uint8_t id = tab->ids[sport] ? tab->ids[sport] : tab->ids[dport];
+    return tab->list[id].fn(c);
+}
+
+void dissector_print(void) {
+    for (int t = 0; t < DISSECT_N_TABLES; t++) {
+        const struct dissect_table *tab = &dissect_tables[t];
+        printf("[%s Dissectors] default: %s\n", tab->name, tab->list[0].name);
+        for (uint32_t key = 0; key < tab->size; key++)
+            if (tab->ids[key]) printf("\t|-%-6u (0x%04X) : %s\n", key, key, tab->list[tab->ids[key]].name);
+    }
+}
+
+#endif
@@ -0,0 +1,403 @@
+// DNS message decoder + query/response latency tracker (header only, just #include it)
+// Names are read with compression pointers followed safely: every pointer must point
+// strictly backwards and at most DNS_MAX_POINTERS are followed, so a crafted message
+// can never loop. Queries are matched to responses by (flow 5-tuple, transaction ID)
+// and all statistics are accumulated in the same single pass over the capture.
+#ifndef DNS_DECODER_H
+#define DNS_DECODER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+#include <arpa/inet.h>
+#include "flow_table.h"
+
+#define DNS_HEADER_LEN 12
+#define DNS_MAX_NAME 256        // 255 octets presentation form + '\0'
+#define DNS_MAX_POINTERS 16     // bound on compression pointer jumps per name
+#define DNS_MAX_RECORDS 64      // bound on records decoded per section
+#define DNS_QUERY_TIMEOUT_US 5000000ULL // unanswered queries older than this are expired
+#define DNS_HIST_BUCKETS 32     // log2 latency buckets in microseconds
+#define DNS_TOP_N 10            // qnames / talkers shown in the report
+#define DNS_TABLE_INIT_SIZE 1024 // must be a power of 2
+
+// --- Message decoding ---
+
+// Read a (possibly compressed) domain name at 'off' into 'out' as lowercase dotted text.
+// Returns the offset just past the name at its original position, or -1 if malformed.
+int dns_read_name(const u_char *msg, uint len, uint off, char *out, uint out_size) {
+    uint pos = off, out_len = 0;
+    int end = -1, jumps = 0;
+
+    while (1) {
+        if (pos >= len) return -1;
+        uint8_t label = msg[pos];
+
+        if ((label & 0xC0) == 0xC0) { // compression pointer (14 bit offset)
+            if (pos + 1 >= len || ++jumps > DNS_MAX_POINTERS) return -1;
+            uint target = ((label & 0x3F) << 8) | msg[pos + 1];
+            if (target >= pos) return -1; // forward/self pointers could loop
+            if (end < 0) end = pos + 2;
+            pos = target;
+            continue;
+        }
+        if (label & 0xC0) return -1; // 0x40 / 0x80 label types are reserved
+        if (label == 0) { pos++; break; }
+
+        if (pos + 1 + label > len || out_len + label + 2 > out_size) return -1;
+        if (out_len) out[out_len++] = '.';
+        for (uint i = 0; i < label; i++) out[out_len++] = (char)tolower(msg[pos + 1 + i]);
+        pos += 1 + label;
+    }
+    if (out_len == 0) out[out_len++] = '.'; // root
+    out[out_len] = '\0';
+    return (end >= 0) ? end : (int)pos;
+}
+
+const char *dns_type_str(uint16_t type) {
+    switch (type) {
+        case 1:   return "A";
+        case 2:   return "NS";
+        case 5:   return "CNAME";
+        case 6:   return "SOA";
+        case 12:  return "PTR";
+        case 15:  return "MX";
+        case 16:  return "TXT";
+        case 28:  return "AAAA";
+        case 33:  return "SRV";
+        case 41:  return "OPT";
+        case 65:  return "HTTPS";
+        case 255: return "ANY";
+        default:  return "OTHER";
+    }
+}
+
+const char *dns_rcode_str(uint16_t rcode) {
+    switch (rcode) {
+        case 0:  return "NoError";
+        case 1:  return "FormErr";
+        case 2:  return "ServFail";
+        case 3:  return "NXDomain";
+        case 4:  return "NotImp";
+        case 5:  return "Refused";
+        default: return "Other";
+    }
+}
+
+// Print one resource record's RDATA in presentation form
+static void dns_print_rdata(const u_char *msg, uint len, uint off, uint16_t type, uint16_t rdlen) {
+    char name[DNS_MAX_NAME], addr[INET6_ADDRSTRLEN];
+    if (type == 1 && rdlen == 4)
+        printf("%s", inet_ntop(AF_INET, msg + off, addr, sizeof(addr)));
+    else if (type == 28 && rdlen == 16)
+        printf("%s", inet_ntop(AF_INET6, msg + off, addr, sizeof(addr)));
+    else if ((type == 2 || type == 5 || type == 12) && dns_read_name(msg, len, off, name, sizeof(name)) > 0)
+        printf("%s", name);
+    else if (type == 15 && rdlen > 2 && dns_read_name(msg, len, off + 2, name, sizeof(name)) > 0)
+        printf("pref:%u %s", ntohs(*(uint16_t *)(msg + off)), name);
+    else if (type == 16 && rdlen > 0) {
+        uint tlen = msg[off] < rdlen - 1 ? msg[off] : rdlen - 1;
+        printf("\"");
+        for (uint i = 0; i < tlen; i++) printf("%c", isprint(msg[off + 1 + i]) ? msg[off + 1 + i] : '.');
+        printf("\"");
+    }
+    else
+        printf("(%u bytes)", rdlen);
+}
+
+// Decode & print the question and answer sections (authority/additional are skipped over)
+void dns_print_message(const u_char *msg, uint len) {
+    if (len < DNS_HEADER_LEN) {
+        printf("\t[DNS] Truncated header!\n");
+        return;
+    }
+    uint16_t qdcount = ntohs(*(uint16_t *)(msg + 4)), ancount = ntohs(*(uint16_t *)(msg + 6));
+    uint16_t flags = ntohs(*(uint16_t *)(msg + 2));
+    char name[DNS_MAX_NAME];
+    int off = DNS_HEADER_LEN;
+
+    if (flags & 0x8000)
+        printf("\t|-Response Code     : %d (%s)\n", flags & 0x000F, dns_rcode_str(flags & 0x000F));
+
+    for (int i = 0; i < qdcount && i < DNS_MAX_RECORDS; i++) {
+        off = dns_read_name(msg, len, off, name, sizeof(name));
+        if (off < 0 || (uint)off + 4 > len) {
+            printf("\t[DNS] Malformed question section!\n");
+            return;
+        }
+        uint16_t qtype = ntohs(*(uint16_t *)(msg + off)), qclass = ntohs(*(uint16_t *)(msg + off + 2));
+        printf("[L7 DNS Question #%d] => |Name:%s|Type:%s(%u)|Class:%u|\n", i + 1, name, dns_type_str(qtype), qtype, qclass);
+        off += 4;
+    }
+
+    for (int i = 0; i < ancount && i < DNS_MAX_RECORDS; i++) {
+        off = dns_read_name(msg, len, off, name, sizeof(name));
+        if (off < 0 || (uint)off + 10 > len) {
+            printf("\t[DNS] Malformed answer section!\n");
+            return;
+        }
+        uint16_t type = ntohs(*(uint16_t *)(msg + off));
+        uint32_t ttl = ntohl(*(uint32_t *)(msg + off + 4));
+        uint16_t rdlen = ntohs(*(uint16_t *)(msg + off + 8));
+        off += 10;
+        if ((uint)off + rdlen > len) {
+            printf("\t[DNS] Truncated answer RDATA!\n");
+            return;
+        }
+        printf("[L7 DNS Answer #%d] => |Name:%s|Type:%s(%u)|TTL:%u|Data:", i + 1, name, dns_type_str(type), type, ttl);
+        dns_print_rdata(msg, len, off, type, rdlen);
+        printf("|\n");
+        off += rdlen;
+    }
+}
+
+// --- Query/response tracking ---
+
+struct dns_pending {    // one outstanding query
+    struct flow_key key; // query direction 5-tuple (client -> server)
+    uint16_t id;         // transaction id
+    uint8_t used;
+    uint64_t ts_us;      // query timestamp
+};
+
+struct dns_qname_stats {
+    char name[DNS_MAX_NAME];
+    uint8_t used;
+    uint64_t queries, answered, nxdomain;
+    uint64_t lat_min, lat_max, lat_sum; // microseconds
+    uint32_t hist[DNS_HIST_BUCKETS];    // bucket i: [2^(i-1), 2^i) us, bucket 0: < 1us
+};
+
+struct dns_tracker {
+    struct dns_pending *pending;
+    uint32_t pending_size, pending_count;
+    struct dns_qname_stats *qnames;
+    uint32_t qname_size, qname_count;
+    struct flow_table talkers; // per client address (ports/dst zeroed) query counts
+    uint64_t queries, responses, matched, unmatched, expired, malformed;
+};
+
+void dns_tracker_init(struct dns_tracker *t) {
+    memset(t, 0, sizeof(*t));
+    t->pending_size = t->qname_size = DNS_TABLE_INIT_SIZE;
+    t->pending = (struct dns_pending *)calloc(t->pending_size, sizeof(struct dns_pending));
+    t->qnames = (struct dns_qname_stats *)calloc(t->qname_size, sizeof(struct dns_qname_stats));
+    flow_table_init(&t->talkers);
+}
+
+static inline uint32_t dns_pending_hash(const struct flow_key *k, uint16_t id) {
+    return (uint32_t)(flow_hash(k) ^ (id * 0x9E3779B1u));
+}
+
+static struct dns_pending *dns_pending_slot(struct dns_pending *tab, uint32_t size, const struct flow_key *k, uint16_t id) {
+    uint32_t mask = size - 1, i = dns_pending_hash(k, id) & mask;
+    while (tab[i].used && !(tab[i].id == id && memcmp(&tab[i].key, k, sizeof(*k)) == 0))
+        i = (i + 1) & mask;
+    return &tab[i];
+}
+
+// Linear probing delete without tombstones: shift back following entries of the cluster
+static void dns_pending_remove(struct dns_tracker *t, struct dns_pending *e) {
+    uint32_t mask = t->pending_size - 1, hole = e - t->pending, i = hole;
+    while (1) {
+        i = (i + 1) & mask;
+        if (!t->pending[i].used) break;
+        uint32_t home = dns_pending_hash(&t->pending[i].key, t->pending[i].id) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) { // entry may move back into the hole
+            t->pending[hole] = t->pending[i];
+            hole = i;
+        }
+    }
+    t->pending[hole].used = 0;
+    t->pending_count--;
+}
+
+// Rebuild the pending table (dropping queries older than the timeout), doubling if still busy
+static void dns_pending_rebuild(struct dns_tracker *t, uint64_t now_us) {
+    uint32_t live = 0;
+    for (uint32_t i = 0; i < t->pending_size; i++)
+        if (t->pending[i].used && now_us - t->pending[i].ts_us <= DNS_QUERY_TIMEOUT_US) live++;
+
+    uint32_t new_size = t->pending_size;
+    if ((live + 1) * 2 > new_size) new_size *= 2; // keep load <= 50% after rebuild
+    struct dns_pending *tab = (struct dns_pending *)calloc(new_size, sizeof(struct dns_pending));
+    for (uint32_t i = 0; i < t->pending_size; i++) {
+        struct dns_pending *e = &t->pending[i];
+        if (!e->used) continue;
+        if (now_us - e->ts_us > DNS_QUERY_TIMEOUT_US) { t->expired++; continue; }
+        *dns_pending_slot(tab, new_size, &e->key, e->id) = *e;
+    }
+    free(t->pending);
+    t->pending = tab;
+    t->pending_size = new_size;
+    t->pending_count = live;
+}
+
+static inline uint32_t dns_name_hash(const char *s) { // FNV-1a
+    uint32_t h = 2166136261u;
+    while (*s) h = (h ^ (uint8_t)*s++) * 16777619u;
+    return h;
+}
+
+static struct dns_qname_stats *dns_qname_slot(struct dns_qname_stats *tab, uint32_t size, const char *name) {
+    uint32_t mask = size - 1, i = dns_name_hash(name) & mask;
+    while (tab[i].used && strcmp(tab[i].name, name) != 0)
+        i = (i + 1) & mask;
+    return &tab[i];
+}
+
+static struct dns_qname_stats *dns_qname_get(struct dns_tracker *t, const char *name) {
+    if ((t->qname_count + 1) * 4 > t->qname_size * 3) { // grow at 75% load
+        uint32_t new_size = t->qname_size * 2;
+        struct dns_qname_stats *tab = (struct dns_qname_stats *)calloc(new_size, sizeof(struct dns_qname_stats));
+        for (uint32_t i = 0; i < t->qname_size; i++)
+            if (t->qnames[i].used) *dns_qname_slot(tab, new_size, t->qnames[i].name) = t->qnames[i];
+        free(t->qnames);
+        t->qnames = tab;
+        t->qname_size = new_size;
+    }
+    struct dns_qname_stats *q = dns_qname_slot(t->qnames, t->qname_size, name);
+    if (!q->used) {
+        q->used = 1;
+        strcpy(q->name, name);
+        q->lat_min = UINT64_MAX;
+        t->qname_count++;
+    }
+    return q;
+}
+
+static inline int dns_hist_bucket(uint64_t us) {
+    int b = 0;
+    while (us && b < DNS_HIST_BUCKETS - 1) { us >>= 1; b++; }
+    return b;
+}
+
+// Feed one DNS message seen on 'flow' (as captured: src -> dst) at time ts_us
+void dns_track(struct dns_tracker *t, const struct flow_key *flow, uint64_t ts_us, const u_char *msg, uint len) {
+    char qname[DNS_MAX_NAME];
+    if (len < DNS_HEADER_LEN || ntohs(*(uint16_t *)(msg + 4)) == 0 ||
+        dns_read_name(msg, len, DNS_HEADER_LEN, qname, sizeof(qname)) < 0) {
+        t->malformed++;
+        return;
+    }
+    uint16_t id = ntohs(*(uint16_t *)msg), flags = ntohs(*(uint16_t *)(msg + 2));
+    struct dns_qname_stats *q = dns_qname_get(t, qname);
+
+    if (!(flags & 0x8000)) { // query: remember it, keyed in client -> server direction
+        t->queries++;
+        q->queries++;
+
+        struct flow_key client = {0};
+        memcpy(client.src, flow->src, sizeof(client.src));
+        client.proto = flow->proto;
+        client.family = flow->family;
+        flow_table_update(&t->talkers, &client, 1);
+
+        if ((t->pending_count + 1) * 4 > t->pending_size * 3) dns_pending_rebuild(t, ts_us);
+        struct dns_pending *p = dns_pending_slot(t->pending, t->pending_size, flow, id);
+        if (!p->used) {
+            p->used = 1;
+            p->key = *flow;
+            p->id = id;
+            t->pending_count++;
+        }
+        p->ts_us = ts_us; // a retransmitted query restarts the clock
+        return;
+    }
+
+    // response: look up the query with the 5-tuple reversed
+    t->responses++;
+    struct flow_key rev = *flow;
+    memcpy(rev.src, flow->dst, sizeof(rev.src));
+    memcpy(rev.dst, flow->src, sizeof(rev.dst));
+    rev.sport = flow->dport;
+    rev.dport = flow->sport;
+
+    struct dns_pending *p = dns_pending_slot(t->pending, t->pending_size, &rev, id);
+    if (!p->used) {
+        t->unmatched++;
+        return;
+    }
+    uint64_t lat = (ts_us >= p->ts_us) ? ts_us - p->ts_us : 0;
+    dns_pending_remove(t, p);
+
+    t->matched++;
+    q->answered++;
+    if ((flags & 0x000F) == 3) q->nxdomain++;
+    if (lat < q->lat_min) q->lat_min = lat;
+    if (lat > q->lat_max) q->lat_max = lat;
+    q->lat_sum += lat;
+    q->hist[dns_hist_bucket(lat)]++;
+}
+
+// Upper bound (us) of the bucket holding the given percentile
+static uint64_t dns_hist_percentile(const struct dns_qname_stats *q, double pct) {
+    uint64_t rank = (uint64_t)(q->answered * pct / 100.0 + 0.5), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int b = 0; b < DNS_HIST_BUCKETS; b++) {
+        seen += q->hist[b];
+        if (seen >= rank) return (b == 0) ? 0 : (1ULL << b) - 1;
+    }
+    return q->lat_max;
+}
+
+static int dns_cmp_queries(const void *a, const void *b) {
+    const struct dns_qname_stats *x = *(const struct dns_qname_stats * const *)a, *y = *(const struct dns_qname_stats * const *)b;
+    return (x->queries < y->queries) - (x->queries > y->queries); // descending
+}
+
+void dns_tracker_report(struct dns_tracker *t) {
+    if (t->queries + t->responses + t->malformed == 0) return;
+    printf("\n[DNS Summary] queries:%llu responses:%llu matched:%llu unmatched-responses:%llu "
+           "unanswered:%llu malformed:%llu\n",
+           (unsigned long long)t->queries, (unsigned long long)t->responses, (unsigned long long)t->matched,
+           (unsigned long long)t->unmatched, (unsigned long long)(t->expired + t->pending_count),
+           (unsigned long long)t->malformed);
+
+    struct dns_qname_stats **list = (struct dns_qname_stats **)malloc((t->qname_count + 1) * sizeof(*list));
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < t->qname_size; i++)
+        if (t->qnames[i].used) list[n++] = &t->qnames[i];
+    qsort(list, n, sizeof(*list), dns_cmp_queries);
+
+    printf("[DNS Top QNames] %u names (top %d by queries, latency in us)\n", n, DNS_TOP_N);
+    for (uint32_t i = 0; i < n && i < DNS_TOP_N; i++) {
+        struct dns_qname_stats *q = list[i];
+        printf("\t|-%-32s queries:%llu answered:%llu nxdomain:%llu", q->name, (unsigned long long)q->queries,
+               (unsigned long long)q->answered, (unsigned long long)q->nxdomain);
+        if (q->answered) {
+            printf(" | min:%llu avg:%llu p50:<=%llu p99:<=%llu max:%llu\n\t   histogram(log2 us):",
+                   (unsigned long long)q->lat_min, (unsigned long long)(q->lat_sum / q->answered),
+                   (unsigned long long)dns_hist_percentile(q, 50), (unsigned long long)dns_hist_percentile(q, 99),
+                   (unsigned long long)q->lat_max);
+            for (int b = 0; b < DNS_HIST_BUCKETS; b++)
+                if (q->hist[b]) printf(" [<%lluus]:%u", 1ULL << b, q->hist[b]);
+        }
+        printf("\n");
+    }
+    free(list);
+
+    printf("[DNS Top Talkers] %u clients\n", t->talkers.count);
+    struct flow_entry **talk = (struct flow_entry **)malloc((t->talkers.count + 1) * sizeof(*talk));
+    n = 0;
+    for (uint32_t i = 0; i < t->talkers.size; i++)
+        if (t->talkers.slots[i].used) talk[n++] = &t->talkers.slots[i];
+    qsort(talk, n, sizeof(*talk), flow_cmp_bytes); // bytes == queries for this table
+    char ip[INET6_ADDRSTRLEN];
+    for (uint32_t i = 0; i < n && i < DNS_TOP_N; i++) {
+        const struct flow_key *k = &talk[i]->key;
+        inet_ntop(k->family, (k->family == AF_INET) ? k->src + 12 : k->src, ip, sizeof(ip));
+        printf("\t|-%-40s queries:%llu\n", ip, (unsigned long long)talk[i]->packets);
+    }
+    free(talk);
+}
+
+void dns_tracker_free(struct dns_tracker *t) {
+    free(t->pending);
+    free(t->qnames);
+    flow_table_free(&t->talkers);
+}
+
+#endif
@@ -0,0 +1,151 @@
+// Flow table shared by the decoders (header only, just #include it)
+// Every flow is keyed by a fixed 40-byte key: IPv4 addresses are stored as
+// v4-mapped IPv6 (::ffff:a.b.c.d), so IPv4 and IPv6 flows hash, compare and
+// count through exactly the same code path at the same cost.
+#ifndef FLOW_TABLE_H
+#define FLOW_TABLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define FLOW_TABLE_INIT_SIZE 1024 // must be a power of 2
+#define FLOW_TOP_N 10             // flows shown in the exit summary
+
+struct flow_key {
+    uint8_t src[16];   // source address (v4-mapped for IPv4)
+    uint8_t dst[16];   // destination address (v4-mapped for IPv4)
+    uint16_t sport;    // L4 source port (0 if the protocol has none)
+    uint16_t dport;    // L4 destination port
+    uint8_t proto;     // final L4 protocol (after IPv6 extension headers)
+    uint8_t family;    // AF_INET / AF_INET6, kept only for printing
+    uint16_t pad;      // explicit padding, always 0 so memcmp() is safe
+};
+
+struct flow_entry {
+    struct flow_key key;
+    uint64_t packets, bytes;
+    uint8_t used;
+};
+
+struct flow_table {
+    struct flow_entry *slots;
+    uint32_t size;  // number of slots (power of 2)
+    uint32_t count; // occupied slots
+};
+
+// Fill address part of a key; IPv4 is widened into the v4-mapped form
+static inline void flow_key_v4(struct flow_key *k, const void *src4, const void *dst4) {
+    memset(k, 0, sizeof(*k));
+    k->src[10] = k->src[11] = 0xff; memcpy(k->src + 12, src4, 4);
+    k->dst[10] = k->dst[11] = 0xff; memcpy(k->dst + 12, dst4, 4);
+    k->family = AF_INET;
+}
+
+static inline void flow_key_v6(struct flow_key *k, const void *src6, const void *dst6) {
+    memset(k, 0, sizeof(*k));
+    memcpy(k->src, src6, 16);
+    memcpy(k->dst, dst6, 16);
+    k->family = AF_INET6;
+}
+
+// 64-bit multiply/xor-shift mix over the five 8-byte words of the key
+static inline uint64_t flow_hash(const struct flow_key *k) {
+    uint64_t w[5], h = 0x9E3779B97F4A7C15ULL;
+    memcpy(w, k, sizeof(w));
+    for (int i = 0; i < 5; i++) {
+        h ^= w[i];
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+void flow_table_init(struct flow_table *ft) {
+    ft->size = FLOW_TABLE_INIT_SIZE;
+    ft->count = 0;
+    ft->slots = (struct flow_entry *)calloc(ft->size, sizeof(struct flow_entry));
+}
+
+// Linear probing; the caller guarantees at least one free slot
+static struct flow_entry *flow_slot(struct flow_entry *slots, uint32_t size, const struct flow_key *k) {
+    uint32_t mask = size - 1, i = (uint32_t)flow_hash(k) & mask;
+    while (slots[i].used && memcmp(&slots[i].key, k, sizeof(*k)) != 0)
+        i = (i + 1) & mask;
+    return &slots[i];
+}
+
+static void flow_table_grow(struct flow_table *ft) {
+    uint32_t new_size = ft->size * 2;
+    struct flow_entry *new_slots = (struct flow_entry *)calloc(new_size, sizeof(struct flow_entry));
+    for (uint32_t i = 0; i < ft->size; i++)
+        if (ft->slots[i].used)
+            *flow_slot(new_slots, new_size, &ft->slots[i].key) = ft->slots[i];
+    free(ft->slots);
+    ft->slots = new_slots;
+    ft->size = new_size;
+}
+
+// Account one packet of 'len' bytes to its flow, creating the flow on first sight
+struct flow_entry *flow_table_update(struct flow_table *ft, const struct flow_key *k, uint32_t len) {
+    if ((ft->count + 1) * 4 > ft->size * 3) flow_table_grow(ft); // keep load <= 75%
+    struct flow_entry *e = flow_slot(ft->slots, ft->size, k);
+    if (!e->used) {
+        e->used = 1;
+        e->key = *k;
+        ft->count++;
+    }
+    e->packets++;
+    e->bytes += len;
+    return e;
+}
+
+// Render "addr:port" from the key (v4-mapped ones print as dotted quad, IPv6 as [addr]:port)
+const char *flow_endpoint_str(const struct flow_key *k, const uint8_t *addr, uint16_t port, char *buf, size_t len) {
+    char ip[INET6_ADDRSTRLEN];
+    if (k->family == AF_INET) {
+        inet_ntop(AF_INET, addr + 12, ip, sizeof(ip));
+        snprintf(buf, len, "%s:%u", ip, port);
+    } else {
+        inet_ntop(AF_INET6, addr, ip, sizeof(ip));
+        snprintf(buf, len, "[%s]:%u", ip, port);
+    }
+    return buf;
+}
+
+static int flow_cmp_bytes(const void *a, const void *b) {
+    const struct flow_entry *x = *(const struct flow_entry * const *)a, *y = *(const struct flow_entry * const *)b;
+    return (x->bytes < y->bytes) - (x->bytes > y->bytes); // descending
+}
+
+void flow_table_print(struct flow_table *ft) {
+    if (ft->count == 0) return;
+    struct flow_entry **list = (struct flow_entry **)malloc(ft->count * sizeof(*list));
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < ft->size; i++)
+        if (ft->slots[i].used) list[n++] = &ft->slots[i];
+    qsort(list, n, sizeof(*list), flow_cmp_bytes);
+
+    char s[INET6_ADDRSTRLEN + 8], d[INET6_ADDRSTRLEN + 8];
+    printf("\n[Flow Summary] %u flows (top %d by bytes)\n", n, FLOW_TOP_N);
+    for (uint32_t i = 0; i < n && i < FLOW_TOP_N; i++) {
+        struct flow_key *k = &list[i]->key;
+        printf("\t|-%-4s proto:%-3u %s -> %s | pkts:%llu bytes:%llu\n",
+               k->family == AF_INET ? "IPv4" : "IPv6", k->proto,
+               flow_endpoint_str(k, k->src, k->sport, s, sizeof(s)),
+               flow_endpoint_str(k, k->dst, k->dport, d, sizeof(d)),
+               (unsigned long long)list[i]->packets, (unsigned long long)list[i]->bytes);
+    }
+    free(list);
+}
+
+void flow_table_free(struct flow_table *ft) {
+    free(ft->slots);
+    ft->slots = NULL;
+    ft->size = ft->count = 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+// gcc -O2 igmp_bench.c -o igmp_bench
+// Multicast group churn on the IGMP snooping table (igmp_snoop.h), no capture needed
+// ./igmp_bench [groups] [operations] [vlans]
+//   random v2 joins / leaves and v3 ALLOW / BLOCK records over 'groups' groups per VLAN,
+//   the clock advances one second every 10k operations so timers expire along the way,
+//   then forwarding lookups are timed on the resulting table.
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "igmp_snoop.h"
+
+static uint64_t rng_state = 0x2545F4914F6CDD1DULL;
+static inline uint32_t rng(void) { // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+static double elapsed(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t n_groups = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+    uint64_t n_ops = (argc > 2) ? strtoull(argv[2], NULL, 10) : 10000000;
+    uint32_t n_vlans = (argc > 3) ? strtoul(argv[3], NULL, 10) : 16;
+    if (!n_groups || !n_vlans || n_vlans > 4095) return printf("Usage: %s [groups] [operations] [vlans(1-4095)]\n", argv[0]), 1;
+
+    struct igmp_snoop s;
+    igmp_snoop_init(&s);
+    printf(">>> IGMP snooping churn: %u groups x %u VLANs, %llu operations, %d ports\n",
+           n_groups, n_vlans, (unsigned long long)n_ops, IGMP_MAX_PORTS);
+
+    struct timespec t0, t1;
+    uint32_t now_s = 1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint64_t i = 0; i < n_ops; i++) {
+        if (i % 10000 == 0) igmp_snoop_expire(&s, now_s++);
+        uint32_t r = rng();
+        uint32_t group = htonl(0xE1000000u + (r % n_groups)); // 225.x.y.z
+        uint16_t vid = 1 + (r >> 20) % n_vlans;
+        uint port = 1 + (rng() % IGMP_MAX_PORTS);
+        uint8_t src[8];
+        uint32_t s1 = htonl(0x0A000001u + (r & 7)), s2 = htonl(0x0A000100u + (r >> 3 & 7));
+        memcpy(src, &s1, 4);
+        memcpy(src + 4, &s2, 4);
+        switch (r >> 28) {
+            case 0: case 1: case 2: case 3: case 4: case 5: igmp_snoop_join(&s, now_s, vid, port, group); break;
+            case 6: case 7: case 8: case 9: igmp_snoop_leave(&s, vid, port, group); break;
+            case 10: case 11: case 12: igmp_snoop_record(&s, now_s, vid, port, IGMP_ALLOW_NEW_SOURCES, group, 2, src); break;
+            default: igmp_snoop_record(&s, now_s, vid, port, IGMP_BLOCK_OLD_SOURCES, group, 2, src); break;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double churn_s = elapsed(&t0, &t1);
+
+    uint64_t n_lookups = n_ops, hits = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint64_t i = 0; i < n_lookups; i++) {
+        uint32_t r = rng();
+        hits += igmp_snoop_lookup(&s, 1 + (r >> 20) % n_vlans, htonl(0xE1000000u + (r % n_groups)),
+                                  htonl(0x0A000001u + (r & 7))) != 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double lookup_s = elapsed(&t0, &t1);
+
+    printf("\n[Churn]   %.3fs, %.2f M ops/s\n", churn_s, n_ops / churn_s / 1e6);
+    printf("\t|-groups:%u (peak %u) created:%llu removed:%llu slots:%u\n", s.count, s.peak,
+           (unsigned long long)s.created, (unsigned long long)s.removed, s.size);
+    printf("\t|-joins:%llu leaves:%llu expired:%llu untracked sources:%llu\n", (unsigned long long)s.joins,
+           (unsigned long long)s.leaves, (unsigned long long)s.expired, (unsigned long long)s.dropped_sources);
+    printf("[Lookup]  %.3fs, %.2f M lookups/s, %.1f%% forwarded to at least one port\n",
+           lookup_s, n_lookups / lookup_s / 1e6, 100.0 * hits / n_lookups);
+
+    igmp_snoop_free(&s);
+    return 0;
+}
@@ -0,0 +1,389 @@
+// IGMP snooping table built from decoded IGMP messages (header only, just #include it)
+// (VLAN, group) -> set of member ports, one bit per port, ports numbered 1..IGMP_MAX_PORTS
+// like the MAC learner in ../src-mac-learning. Every member port and source has its own
+// expiry timer (Group Membership Interval, refreshed by reports). Timers sit in a wheel
+// of one-second slots: each second of capture time only the groups that have a timer
+// due in that second are checked, and groups left without members are removed.
+//
+// IGMPv3 is handled the lightweight way (RFC 5790): EXCLUDE mode records join the whole
+// group (any source), INCLUDE mode / ALLOW / BLOCK records manage per-source port sets,
+// TO_IN({}) and v2 Leave remove the port immediately (fast leave).
+// Queries mark the port they arrive on as a multicast router port for that VLAN.
+#ifndef IGMP_SNOOP_H
+#define IGMP_SNOOP_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define IGMP_MAX_PORTS 12            // same as MAX_PORTS of the MAC learner
+#define IGMP_GMI_S 260               // robustness(2) * query interval(125s) + max response(10s)
+#define IGMP_TABLE_INIT_SIZE 1024    // must be a power of 2
+#define IGMP_MAX_SOURCES 64          // per group, extra v3 sources are not tracked
+#define IGMP_SHOW_GROUPS 20          // groups listed in the report
+#define IGMP_WHEEL_SIZE 512          // timer wheel slots (seconds), power of 2 > IGMP_GMI_S
+
+#define IGMP_V3_REPORT 0x22
+enum igmp_v3_record { IGMP_MODE_IS_INCLUDE = 1, IGMP_MODE_IS_EXCLUDE, IGMP_CHANGE_TO_INCLUDE,
+                      IGMP_CHANGE_TO_EXCLUDE, IGMP_ALLOW_NEW_SOURCES, IGMP_BLOCK_OLD_SOURCES };
+
+typedef uint16_t igmp_ports; // bit (port - 1)
+
+struct igmp_source {
+    uint32_t addr;                       // network byte order
+    igmp_ports ports;                    // ports that want this source
+    uint32_t expiry_s[IGMP_MAX_PORTS];   // per port, valid only when its bit is set
+};
+
+struct igmp_group {
+    uint32_t group;                      // network byte order, 0 = empty slot
+    uint16_t vid;
+    igmp_ports ports;                    // any-source (v1/v2/EXCLUDE) members
+    uint32_t expiry_s[IGMP_MAX_PORTS];
+    uint16_t n_sources, cap_sources;
+    struct igmp_source *sources;         // INCLUDE mode members, malloc'd on first use
+    uint32_t armed_s;                    // latest expiry second this group was put on the wheel for
+};
+
+struct igmp_timer_ref {                  // "check (vid, group) at this second", may be stale
+    uint32_t group;
+    uint16_t vid;
+};
+
+struct igmp_wheel_slot {
+    struct igmp_timer_ref *refs;
+    uint32_t n, cap;
+};
+
+struct igmp_snoop {
+    struct igmp_group *slots;
+    uint32_t size;                       // power of 2
+    uint32_t count;                      // groups in the table
+    uint32_t peak;
+    uint32_t last_sweep_s;
+    struct igmp_wheel_slot wheel[IGMP_WHEEL_SIZE];
+    igmp_ports mrouter[4096];            // router ports per VLAN
+    uint64_t joins, leaves, queries, expired, created, removed, dropped_sources;
+};
+
+void igmp_snoop_init(struct igmp_snoop *s) {
+    memset(s, 0, sizeof(*s));
+    s->size = IGMP_TABLE_INIT_SIZE;
+    s->slots = (struct igmp_group *)calloc(s->size, sizeof(struct igmp_group));
+    if (!s->slots) {
+        perror("igmp table alloc");
+        exit(1);
+    }
+}
+
+void igmp_snoop_free(struct igmp_snoop *s) {
+    for (uint32_t i = 0; i < s->size; i++) free(s->slots[i].sources);
+    for (uint32_t i = 0; i < IGMP_WHEEL_SIZE; i++) free(s->wheel[i].refs);
+    free(s->slots);
+    s->slots = NULL;
+}
+
+static inline uint32_t igmp_hash(uint32_t group, uint16_t vid) {
+    uint64_t h = ((uint64_t)vid << 32 | group) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(h >> 32);
+}
+
+static inline igmp_ports igmp_port_bit(uint port) {
+    return (port >= 1 && port <= IGMP_MAX_PORTS) ? (igmp_ports)(1u << (port - 1)) : 0;
+}
+
+static void igmp_grow(struct igmp_snoop *s) {
+    struct igmp_group *old = s->slots;
+    uint32_t old_size = s->size;
+    s->size *= 2;
+    s->slots = (struct igmp_group *)calloc(s->size, sizeof(struct igmp_group));
+    if (!s->slots) {
+        perror("igmp table grow");
+        exit(1);
+    }
+    for (uint32_t i = 0; i < old_size; i++) {
+        if (!old[i].group) continue;
+        uint32_t idx = igmp_hash(old[i].group, old[i].vid) & (s->size - 1);
+        while (s->slots[idx].group) idx = (idx + 1) & (s->size - 1);
+        s->slots[idx] = old[i];
+    }
+    free(old);
+}
+
+// Existing entry, or NULL (create = 0) / a new empty one (create = 1)
+static struct igmp_group *igmp_find(struct igmp_snoop *s, uint32_t group, uint16_t vid, int create) {
+    if (create && (s->count + 1) * 4 > s->size * 3) igmp_grow(s);
+    uint32_t idx = igmp_hash(group, vid) & (s->size - 1);
+    while (s->slots[idx].group) {
+        if (s->slots[idx].group == group && s->slots[idx].vid == vid) return &s->slots[idx];
+        idx = (idx + 1) & (s->size - 1);
+    }
+    if (!create) return NULL;
+    struct igmp_group *g = &s->slots[idx];
+    g->group = group;
+    g->vid = vid;
+    s->created++;
+    if (++s->count > s->peak) s->peak = s->count;
+    return g;
+}
+
+// Linear probing delete without tombstones: shift back following entries of the cluster
+static void igmp_remove(struct igmp_snoop *s, struct igmp_group *g) {
+    uint32_t mask = s->size - 1, hole = g - s->slots, i = hole;
+    free(g->sources);
+    while (1) {
+        i = (i + 1) & mask;
+        if (!s->slots[i].group) break;
+        uint32_t home = igmp_hash(s->slots[i].group, s->slots[i].vid) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) { // entry may move back into the hole
+            s->slots[hole] = s->slots[i];
+            hole = i;
+        }
+    }
+    memset(&s->slots[hole], 0, sizeof(struct igmp_group));
+    s->count--;
+    s->removed++;
+}
+
+static inline int igmp_group_empty(const struct igmp_group *g) {
+    return !g->ports && !g->n_sources;
+}
+
+static struct igmp_source *igmp_source_find(struct igmp_snoop *s, struct igmp_group *g, uint32_t addr, int create) {
+    for (uint16_t i = 0; i < g->n_sources; i++)
+        if (g->sources[i].addr == addr) return &g->sources[i];
+    if (!create) return NULL;
+    if (g->n_sources == IGMP_MAX_SOURCES) {
+        s->dropped_sources++;
+        return NULL;
+    }
+    if (g->n_sources == g->cap_sources) {
+        uint16_t cap = g->cap_sources ? g->cap_sources * 2 : 4;
+        struct igmp_source *p = (struct igmp_source *)realloc(g->sources, cap * sizeof(struct igmp_source));
+        if (!p) {
+            perror("igmp source alloc");
+            exit(1);
+        }
+        g->sources = p;
+        g->cap_sources = cap;
+    }
+    struct igmp_source *src = &g->sources[g->n_sources++];
+    memset(src, 0, sizeof(*src));
+    src->addr = addr;
+    return src;
+}
+
+// Drop 'port' from a source; the last entry fills the gap of an emptied source
+static void igmp_source_drop(struct igmp_group *g, struct igmp_source *src, igmp_ports bit) {
+    src->ports &= ~bit;
+    if (!src->ports) *src = g->sources[--g->n_sources];
+}
+
+// Queue a check of 'g' at 'expiry_s' (once per group and second)
+static void igmp_timer_arm(struct igmp_snoop *s, struct igmp_group *g, uint32_t expiry_s) {
+    if (g->armed_s == expiry_s) return;
+    g->armed_s = expiry_s;
+    struct igmp_wheel_slot *w = &s->wheel[expiry_s & (IGMP_WHEEL_SIZE - 1)];
+    if (w->n == w->cap) {
+        uint32_t cap = w->cap ? w->cap * 2 : 64;
+        struct igmp_timer_ref *p = (struct igmp_timer_ref *)realloc(w->refs, cap * sizeof(struct igmp_timer_ref));
+        if (!p) {
+            perror("igmp timer alloc");
+            exit(1);
+        }
+        w->refs = p;
+        w->cap = cap;
+    }
+    w->refs[w->n].group = g->group;
+    w->refs[w->n].vid = g->vid;
+    w->n++;
+}
+
+// Any-source membership (v1/v2 report, v3 EXCLUDE record)
+void igmp_snoop_join(struct igmp_snoop *s, uint32_t now_s, uint16_t vid, uint port, uint32_t group) {
+    igmp_ports bit = igmp_port_bit(port);
+    if (!bit || !group) return;
+    struct igmp_group *g = igmp_find(s, group, vid, 1);
+    g->ports |= bit;
+    g->expiry_s[port - 1] = now_s + IGMP_GMI_S;
+    igmp_timer_arm(s, g, now_s + IGMP_GMI_S);
+    s->joins++;
+}
+
+// Port stops listening to the group (v2 Leave, v3 TO_IN({})), fast leave: no last member query
+void igmp_snoop_leave(struct igmp_snoop *s, uint16_t vid, uint port, uint32_t group) {
+    igmp_ports bit = igmp_port_bit(port);
+    struct igmp_group *g = bit ? igmp_find(s, group, vid, 0) : NULL;
+    if (!g) return;
+    g->ports &= ~bit;
+    s->leaves++;
+    if (igmp_group_empty(g)) igmp_remove(s, g);
+}
+
+// One IGMPv3 group record ('srcs' points at n_src addresses in network byte order)
+void igmp_snoop_record(struct igmp_snoop *s, uint32_t now_s, uint16_t vid, uint port, uint8_t type,
+                       uint32_t group, uint16_t n_src, const uint8_t *srcs) {
+    igmp_ports bit = igmp_port_bit(port);
+    if (!bit || !group) return;
+    switch (type) {
+        case IGMP_MODE_IS_EXCLUDE:
+        case IGMP_CHANGE_TO_EXCLUDE: // EXCLUDE(S) is treated as EXCLUDE({}) = any source
+            igmp_snoop_join(s, now_s, vid, port, group);
+            return;
+        case IGMP_CHANGE_TO_INCLUDE: { // leaves any-source mode, keeps (or joins) only the listed sources
+            if (n_src == 0) {
+                igmp_snoop_leave(s, vid, port, group);
+                return;
+            }
+            struct igmp_group *g = igmp_find(s, group, vid, 0);
+            if (g) g->ports &= ~bit;
+            break;
+        }
+        case IGMP_MODE_IS_INCLUDE:
+        case IGMP_ALLOW_NEW_SOURCES:
+        case IGMP_BLOCK_OLD_SOURCES:
+            break;
+        default:
+            return;
+    }
+    if (n_src == 0) return;
+
+    struct igmp_group *g = igmp_find(s, group, vid, type != IGMP_BLOCK_OLD_SOURCES);
+    if (!g) return;
+    for (uint16_t i = 0; i < n_src; i++) {
+        uint32_t addr;
+        memcpy(&addr, srcs + 4 * i, 4);
+        struct igmp_source *src = igmp_source_find(s, g, addr, type != IGMP_BLOCK_OLD_SOURCES);
+        if (!src) continue;
+        if (type == IGMP_BLOCK_OLD_SOURCES) {
+            igmp_source_drop(g, src, bit);
+        } else {
+            src->ports |= bit;
+            src->expiry_s[port - 1] = now_s + IGMP_GMI_S;
+        }
+    }
+    if (type != IGMP_BLOCK_OLD_SOURCES) igmp_timer_arm(s, g, now_s + IGMP_GMI_S);
+    if (type == IGMP_BLOCK_OLD_SOURCES) s->leaves++;
+    else s->joins++;
+    if (igmp_group_empty(g)) igmp_remove(s, g);
+}
+
+void igmp_snoop_query(struct igmp_snoop *s, uint16_t vid, uint port) {
+    s->mrouter[vid & 0x0FFF] |= igmp_port_bit(port);
+    s->queries++;
+}
+
+// Drop the members of one group whose timer ran out, returns 1 if the group became empty
+static int igmp_group_expire(struct igmp_snoop *s, struct igmp_group *g, uint32_t now_s) {
+    for (uint p = 0; p < IGMP_MAX_PORTS; p++)
+        if ((g->ports >> p & 1) && g->expiry_s[p] <= now_s) {
+            g->ports &= ~(1u << p);
+            s->expired++;
+        }
+    for (uint16_t k = 0; k < g->n_sources;) {
+        struct igmp_source *src = &g->sources[k];
+        uint16_t before = g->n_sources;
+        for (uint p = 0; p < IGMP_MAX_PORTS && src->ports; p++)
+            if ((src->ports >> p & 1) && src->expiry_s[p] <= now_s) {
+                igmp_source_drop(g, src, 1u << p);
+                s->expired++;
+                if (g->n_sources != before) break; // source removed, slot k now holds another one
+            }
+        if (g->n_sources == before) k++;
+    }
+    return igmp_group_empty(g);
+}
+
+// Advance the timer wheel to capture time 'now_s', expiring what fell due on the way
+void igmp_snoop_expire(struct igmp_snoop *s, uint32_t now_s) {
+    if (now_s <= s->last_sweep_s) return;
+    uint32_t steps = now_s - s->last_sweep_s;
+    if (steps > IGMP_WHEEL_SIZE) steps = IGMP_WHEEL_SIZE; // long gap: every slot once
+    s->last_sweep_s = now_s;
+    for (uint32_t t = now_s - steps + 1; steps--; t++) {
+        struct igmp_wheel_slot *w = &s->wheel[t & (IGMP_WHEEL_SIZE - 1)];
+        for (uint32_t i = 0; i < w->n; i++) {
+            struct igmp_group *g = igmp_find(s, w->refs[i].group, w->refs[i].vid, 0);
+            if (g && igmp_group_expire(s, g, now_s)) igmp_remove(s, g);
+        }
+        w->n = 0;
+    }
+}
+
+// Ports a packet from 'source' to (vid, group) is forwarded to: members + router ports
+igmp_ports igmp_snoop_lookup(struct igmp_snoop *s, uint16_t vid, uint32_t group, uint32_t source) {
+    igmp_ports out = s->mrouter[vid & 0x0FFF];
+    struct igmp_group *g = igmp_find(s, group, vid, 0);
+    if (!g) return out;
+    out |= g->ports;
+    for (uint16_t i = 0; i < g->n_sources; i++)
+        if (g->sources[i].addr == source) out |= g->sources[i].ports;
+    return out;
+}
+
+// Feed one IGMP message received on 'port' (len = bytes available from the IGMP header)
+void igmp_snoop_packet(struct igmp_snoop *s, uint32_t now_s, uint16_t vid, uint port, const uint8_t *msg, uint len) {
+    if (len < 8) return;
+    igmp_snoop_expire(s, now_s);
+    uint32_t group;
+    memcpy(&group, msg + 4, 4);
+    switch (msg[0]) {
+        case 0x11: igmp_snoop_query(s, vid, port); break;              // Membership Query (v1/v2/v3)
+        case 0x12: case 0x16: igmp_snoop_join(s, now_s, vid, port, group); break; // v1 / v2 report
+        case 0x17: igmp_snoop_leave(s, vid, port, group); break;       // v2 Leave Group
+        case IGMP_V3_REPORT: {
+            uint n_rec = msg[6] << 8 | msg[7], off = 8;
+            for (uint r = 0; r < n_rec && off + 8 <= len; r++) {
+                uint16_t n_src = msg[off + 2] << 8 | msg[off + 3];
+                uint rec_len = 8 + 4 * n_src + 4 * msg[off + 1]; // + aux data (32-bit words)
+                if (off + rec_len > len) break;
+                memcpy(&group, msg + off + 4, 4);
+                igmp_snoop_record(s, now_s, vid, port, msg[off], group, n_src, msg + off + 8);
+                off += rec_len;
+            }
+            break;
+        }
+    }
+}
+
+static void igmp_ports_str(igmp_ports ports, char *buf, size_t len) {
+    size_t used = 0;
+    buf[0] = '\0';
+    for (uint p = 1; p <= IGMP_MAX_PORTS && used < len; p++)
+        if (ports & igmp_port_bit(p)) used += snprintf(buf + used, len - used, used ? ",%u" : "%u", p);
+    if (!used) snprintf(buf, len, "-");
+}
+
+void igmp_snoop_report(struct igmp_snoop *s) {
+    if (!s->joins && !s->leaves && !s->queries) return;
+    printf("\n[IGMP Snooping] groups:%u (peak %u) joins:%llu leaves:%llu queries:%llu expired:%llu\n",
+           s->count, s->peak, (unsigned long long)s->joins, (unsigned long long)s->leaves,
+           (unsigned long long)s->queries, (unsigned long long)s->expired);
+    char ports[48];
+    for (uint vid = 0; vid < 4096; vid++)
+        if (s->mrouter[vid]) {
+            igmp_ports_str(s->mrouter[vid], ports, sizeof(ports));
+            printf("\t|-VLAN %-4u router ports: %s\n", vid, ports);
+        }
+    uint shown = 0;
+    for (uint32_t i = 0; i < s->size && shown < IGMP_SHOW_GROUPS; i++) {
+        const struct igmp_group *g = &s->slots[i];
+        if (!g->group) continue;
+        char grp[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &g->group, grp, sizeof(grp));
+        igmp_ports_str(g->ports, ports, sizeof(ports));
+        printf("\t|-VLAN %-4u %-15s ports: %-12s sources: %u\n", g->vid, grp, ports, g->n_sources);
+        for (uint16_t k = 0; k < g->n_sources; k++) {
+            char src[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, &g->sources[k].addr, src, sizeof(src));
+            igmp_ports_str(g->sources[k].ports, ports, sizeof(ports));
+            printf("\t\t(%s) ports: %s\n", src, ports);
+        }
+        shown++;
+    }
+    if (s->count > shown) printf("\t(%u more groups not listed)\n", s->count - shown);
+}
+
+#endif
@@ -4,12 +4,16 @@
 #include <stdlib.h>
 #include <arpa/inet.h>
 #include <net/ethernet.h>
+#include "arp_cache.h" // IP->MAC bindings + gratuitous/duplicate/spoof detection
 
 #define ETHERTYPE_QINQ 0x88a8 // not defined in std libs
 #define header_scale 4
 #define fragment_scale 8
+#define ipv6_ext_scale 8 // extension header length unit (excluding first 8 bytes)
+#define IPV6_MAX_EXT_HDRS 8 // bound on the extension header chain walk
 
 static uint n = 0;
+static struct arp_cache arp_cache; // hex dumps carry no timestamps: bindings never age here
 
 // Structs for internal organization
 struct eth_info {
@@ -31,6 +35,13 @@ struct ip_info {
     struct in_addr src, dst; // ipv4's source & destination address pair
 };
 
+struct ip6_info {
+    uint32_t vtc_flow; // version(4) | traffic class(8) | flow label(20)
+    uint16_t plen; // payload length (extension headers included)
+    uint8_t nxt, hlim; // next header, hop limit
+    struct in6_addr src, dst; // ipv6's source & destination address pair
+};
+
 // Helper to read a specific number of hex bytes from file and return as uint32 
 uint read_hex(FILE *fp, int bytes) {
     if (bytes>4){
@@ -45,6 +56,11 @@ uint read_hex(FILE *fp, int bytes) {
     return val;
 }
 
+// Helper to read a 16 byte IPv6 address (too wide for read_hex)
+void read_in6(FILE *fp, struct in6_addr *addr) {
+    for (int i = 0; i < 16; i++) addr->s6_addr[i] = (uint8_t)read_hex(fp, 1);
+}
+
 
 void process_packet(FILE *fp) {
     printf("\n=== PACKET FRAME %d ===\n", ++n);
@@ -64,6 +80,7 @@ void process_packet(FILE *fp) {
     uint16_t current_eth_type = eth.type;
     uint eth_header_len = 14; // SA(6)+DA(6)+Len(2) --> note CRC(4) is trailer after data payload, thus not included
     int vlan_count = 0;
+    uint16_t vid = 0; // innermost VLAN id
 
     while (current_eth_type == ETHERTYPE_VLAN || current_eth_type == ETHERTYPE_QINQ) {
         uint16_t tci = (uint16_t)read_hex(fp, 2);
@@ -75,6 +92,7 @@ void process_packet(FILE *fp) {
         printf("|Priority(PCP):%d", (tci >> 13) & 0x07);
         printf("|Drop-Eligible(DEI):%d", (tci >> 12) & 0x01);
         printf("|VID:%d\n", (tci & 0x0FFF));
+        vid = tci & 0x0FFF;
 
         current_eth_type = next_type;
         eth_header_len += 4;
@@ -112,54 +130,130 @@ void process_packet(FILE *fp) {
         printf("\t|-Sender IP         : %s\n", inet_ntoa(sa));
         printf("\t|-Target MAC        : %02X:%02X:%02X:%02X:%02X:%02X\n", arp.tha[0],arp.tha[1],arp.tha[2],arp.tha[3],arp.tha[4],arp.tha[5]);
         printf("\t|-Target IP         : %s\n", inet_ntoa(ta));
+
+        if (current_eth_type == ETHERTYPE_ARP && arp.hrd == 1 && arp.pro == ETHERTYPE_IP &&
+            arp.hln == 6 && arp.pln == 4 && (arp.op == 1 || arp.op == 2)) {
+            enum arp_verdict v = arp_cache_observe(&arp_cache, 0, vid, arp.op, eth.s_mac, arp.sha, sa.s_addr, ta.s_addr);
+            printf("\t|-ARP Cache         : %s\n", arp_verdict_names[v]);
+        }
         return;
     }
 
-    if (current_eth_type != ETHERTYPE_IP) {
-        printf("Unknown EtherType! Valid types = IPv4:%04X, skipping unpacking further...\n", ETHERTYPE_IP);
+    if (current_eth_type != ETHERTYPE_IP && current_eth_type != ETHERTYPE_IPV6) {
+        printf("Unknown EtherType! Valid types = IPv4:%04X, IPv6:%04X, skipping unpacking further...\n",
+               ETHERTYPE_IP, ETHERTYPE_IPV6);
         return;
     }
 
-    // --- Layer 3: IPv4 Header ---
-    struct ip_info ip;
-    uint8_t ver_ihl = (uint8_t)read_hex(fp, 1);
-    ip.v = (ver_ihl >> 4);
-    ip.hl = (ver_ihl & 0x0F);
-    ip.tos = (uint8_t)read_hex(fp, 1);
-    ip.len = (uint16_t)read_hex(fp, 2);
-    ip.id  = (uint16_t)read_hex(fp, 2);
-    ip.off = (uint16_t)read_hex(fp, 2);
-    ip.ttl = (uint8_t)read_hex(fp, 1);
-    ip.p   = (uint8_t)read_hex(fp, 1);
-    ip.sum = (uint16_t)read_hex(fp, 2);
-    ip.src.s_addr = htonl(read_hex(fp, 4));
-    ip.dst.s_addr = htonl(read_hex(fp, 4));
-
-    uint ip_hdr_bytes = ip.hl * header_scale;
-    uint ip_frag_offset = (ip.off & 0x1FFF) * fragment_scale;
-
-    printf("[L3 IPv4]\n");
-    printf("\t|-IP Version        : %d\n", ip.v);
-    printf("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n", ip.hl, header_scale, ip_hdr_bytes);
-    printf("\t|-Type Of Service   : %d\n", ip.tos);
-    printf("\t|-Total Length      : %d Bytes\n", ip.len);
-    printf("\t|-Identification    : %d\n", ip.id);
-    printf("\t[Flags] => |Reserved-Bit:%d |Dont-Fragment:%d|More-Fragments:%d|\n", 
-        (ip.off >> 15), (ip.off & 0x4000) >> 14, (ip.off & 0x2000) >> 13);
-    printf("\t|-Fragment Offset  => Offset:%d * ScalingFactor:%d = %d\n", (ip.off & 0x1FFF), fragment_scale, ip_frag_offset);
-    printf("\t|-TTL               : %d\n", ip.ttl);
-    printf("\t|-Protocol          : %d\n", ip.p);
-    printf("\t|-Header Checksum   : %d\n", ip.sum);
-    printf("\t|-Source IP         : %s\n", inet_ntoa(ip.src));
-    printf("\t|-Destination IP    : %s\n", inet_ntoa(ip.dst));
-
-    for(int i = 0; i < (int)(ip_hdr_bytes - 20); i++) read_hex(fp, 1); 
+    uint8_t l4_proto; // upper layer protocol (after any IPv6 extension headers)
+    int l3_payload_len; // bytes following the L3 header(s)
+    uint l3_frag_offset; // non-zero => no L4 header in this fragment
+
+    if (current_eth_type == ETHERTYPE_IPV6) {
+        // --- Layer 3: IPv6 Header ---
+        struct ip6_info ip6;
+        ip6.vtc_flow = read_hex(fp, 4);
+        ip6.plen = (uint16_t)read_hex(fp, 2);
+        ip6.nxt = (uint8_t)read_hex(fp, 1);
+        ip6.hlim = (uint8_t)read_hex(fp, 1);
+        read_in6(fp, &ip6.src);
+        read_in6(fp, &ip6.dst);
+
+        char src6[INET6_ADDRSTRLEN], dst6[INET6_ADDRSTRLEN];
+        printf("[L3 IPv6]\n");
+        printf("\t|-IP Version        : %d\n", ip6.vtc_flow >> 28);
+        printf("\t|-Traffic Class     : %d\n", (ip6.vtc_flow >> 20) & 0xFF);
+        printf("\t|-Flow Label        : 0x%05X\n", ip6.vtc_flow & 0xFFFFF);
+        printf("\t|-Payload Length    : %d Bytes\n", ip6.plen);
+        printf("\t|-Next Header       : %d\n", ip6.nxt);
+        printf("\t|-Hop Limit         : %d\n", ip6.hlim);
+        printf("\t|-Source IP         : %s\n", inet_ntop(AF_INET6, &ip6.src, src6, sizeof(src6)));
+        printf("\t|-Destination IP    : %s\n", inet_ntop(AF_INET6, &ip6.dst, dst6, sizeof(dst6)));
+
+        // Extension header chain: every header starts with |next header|length|
+        uint8_t next = ip6.nxt;
+        uint ext_total = 0;
+        l3_frag_offset = 0;
+        for (int hops = 0; hops < IPV6_MAX_EXT_HDRS; hops++) {
+            if (next != IPPROTO_HOPOPTS && next != IPPROTO_ROUTING && next != IPPROTO_FRAGMENT &&
+                next != IPPROTO_DSTOPTS && next != IPPROTO_AH)
+                break;
+            uint8_t this_hdr = next;
+            next = (uint8_t)read_hex(fp, 1);
+            uint8_t len_field = (uint8_t)read_hex(fp, 1);
+            uint ext_len = (len_field + 1) * ipv6_ext_scale, consumed = 2;
+
+            if (this_hdr == IPPROTO_FRAGMENT) {
+                uint16_t offlg = (uint16_t)read_hex(fp, 2);
+                uint32_t ident = read_hex(fp, 4);
+                ext_len = 8; consumed = 8;
+                l3_frag_offset = (offlg >> 3) * fragment_scale;
+                printf("\t[Ext Header] Fragment => |Offset:%d|More-Fragments:%d|Identification:0x%08X|\n",
+                       l3_frag_offset, offlg & 0x1, ident);
+            } else if (this_hdr == IPPROTO_ROUTING) {
+                uint8_t type = (uint8_t)read_hex(fp, 1), segleft = (uint8_t)read_hex(fp, 1);
+                consumed = 4;
+                printf("\t[Ext Header] Routing => |Length:%d Bytes|Type:%d|Segments-Left:%d|\n", ext_len, type, segleft);
+            } else if (this_hdr == IPPROTO_AH) {
+                ext_len = (len_field + 2) * header_scale;
+                printf("\t[Ext Header] Authentication => |Length:%d Bytes|\n", ext_len);
+            } else {
+                printf("\t[Ext Header] %s => |Length:%d Bytes|\n",
+                       (this_hdr == IPPROTO_HOPOPTS) ? "Hop-by-Hop Options" : "Destination Options", ext_len);
+            }
+            for (uint i = consumed; i < ext_len; i++) read_hex(fp, 1);
+            ext_total += ext_len;
+        }
+        l4_proto = next;
+        l3_payload_len = (int)ip6.plen - (int)ext_total;
+    }
+    else {
+        // --- Layer 3: IPv4 Header ---
+        struct ip_info ip;
+        uint8_t ver_ihl = (uint8_t)read_hex(fp, 1);
+        ip.v = (ver_ihl >> 4);
+        ip.hl = (ver_ihl & 0x0F);
+        ip.tos = (uint8_t)read_hex(fp, 1);
+        ip.len = (uint16_t)read_hex(fp, 2);
+        ip.id  = (uint16_t)read_hex(fp, 2);
+        ip.off = (uint16_t)read_hex(fp, 2);
+        ip.ttl = (uint8_t)read_hex(fp, 1);
+        ip.p   = (uint8_t)read_hex(fp, 1);
+        ip.sum = (uint16_t)read_hex(fp, 2);
+        ip.src.s_addr = htonl(read_hex(fp, 4));
+        ip.dst.s_addr = htonl(read_hex(fp, 4));
+
+        uint ip_hdr_bytes = ip.hl * header_scale;
+        uint ip_frag_offset = (ip.off & 0x1FFF) * fragment_scale;
+
+        printf("[L3 IPv4]\n");
+        printf("\t|-IP Version        : %d\n", ip.v);
+        printf("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n", ip.hl, header_scale, ip_hdr_bytes);
+        printf("\t|-Type Of Service   : %d\n", ip.tos);
+        printf("\t|-Total Length      : %d Bytes\n", ip.len);
+        printf("\t|-Identification    : %d\n", ip.id);
+        printf("\t[Flags] => |Reserved-Bit:%d |Dont-Fragment:%d|More-Fragments:%d|\n", 
+            (ip.off >> 15), (ip.off & 0x4000) >> 14, (ip.off & 0x2000) >> 13);
+        printf("\t|-Fragment Offset  => Offset:%d * ScalingFactor:%d = %d\n", (ip.off & 0x1FFF), fragment_scale, ip_frag_offset);
+        printf("\t|-TTL               : %d\n", ip.ttl);
+        printf("\t|-Protocol          : %d\n", ip.p);
+        printf("\t|-Header Checksum   : %d\n", ip.sum);
+        printf("\t|-Source IP         : %s\n", inet_ntoa(ip.src));
+        printf("\t|-Destination IP    : %s\n", inet_ntoa(ip.dst));
+
+        for(int i = 0; i < (int)(ip_hdr_bytes - 20); i++) read_hex(fp, 1); 
+
+        l4_proto = ip.p;
+        l3_payload_len = (int)ip.len - (int)ip_hdr_bytes;
+        l3_frag_offset = ip_frag_offset;
+    }
 
     // --- Layer 4: Transport/Control Layer ---
     uint l4_header_len = 0;
     uint app_header_len = 0;
+    if (l3_frag_offset != 0) l4_proto = IPPROTO_NONE; // later fragments carry no L4 header
 
-    if (ip.p == IPPROTO_TCP) {
+    if (l4_proto == IPPROTO_TCP) {
         uint16_t src_port = read_hex(fp, 2);
         uint16_t dst_port = read_hex(fp, 2);
         uint32_t seq = read_hex(fp, 4);
@@ -183,7 +277,7 @@ void process_packet(FILE *fp) {
         printf("\t|-Urgent Pointer    : %d\n", urp);
         for(int i = 0; i < (int)(l4_header_len - 20); i++) read_hex(fp, 1);
     } 
-    else if (ip.p == IPPROTO_UDP) {
+    else if (l4_proto == IPPROTO_UDP) {
         uint16_t src_port = read_hex(fp, 2);
         uint16_t dst_port = read_hex(fp, 2);
         uint16_t len = read_hex(fp, 2);
@@ -208,7 +302,7 @@ void process_packet(FILE *fp) {
             app_header_len = 12; // DNS header is 12 bytes
         }
     }
-    else if (ip.p == 1) { // ICMP
+    else if (l4_proto == 1) { // ICMP
         uint8_t type = read_hex(fp, 1);
         uint8_t code = read_hex(fp, 1);
         uint16_t cksum = read_hex(fp, 2);
@@ -226,7 +320,7 @@ void process_packet(FILE *fp) {
             printf("\t|-Sequence Number   : %d\n", rest & 0xFFFF);
         }
     }
-    else if (ip.p == 2) { // IGMP
+    else if (l4_proto == 2) { // IGMP
         uint8_t type = read_hex(fp, 1);
         uint8_t mrtc = read_hex(fp, 1);
         uint16_t cksum = read_hex(fp, 2);
@@ -241,9 +335,42 @@ void process_packet(FILE *fp) {
         printf("\t|-Checksum          : %d\n", cksum);
         printf("\t|-Group Address     : %s\n", inet_ntoa(gaddr));
     }
+    else if (l4_proto == 58) { // ICMPv6
+        uint8_t type = read_hex(fp, 1);
+        uint8_t code = read_hex(fp, 1);
+        uint16_t cksum = read_hex(fp, 2);
+        uint32_t rest = read_hex(fp, 4);
+        l4_header_len = 8;
+        printf("[L4 ICMPv6]\n");
+        printf("\t|-Type              : %d ", type);
+        if(type==128) printf("(Echo Request)\n"); else if(type==129) printf("(Echo Reply)\n");
+        else if(type==1) printf("(Dest Unreachable)\n"); else if(type==2) printf("(Packet Too Big)\n");
+        else if(type==3) printf("(Time Exceeded)\n"); else if(type==133) printf("(NDP Router Solicitation)\n");
+        else if(type==134) printf("(NDP Router Advertisement)\n"); else if(type==135) printf("(NDP Neighbor Solicitation)\n");
+        else if(type==136) printf("(NDP Neighbor Advertisement)\n"); else if(type==137) printf("(NDP Redirect)\n");
+        else printf("(Other)\n");
+        printf("\t|-Code              : %d\n", code);
+        printf("\t|-Checksum          : %d\n", cksum);
+        if(type==128 || type==129) {
+            printf("\t|-Identifier        : %d\n", rest >> 16);
+            printf("\t|-Sequence Number   : %d\n", rest & 0xFFFF);
+        }
+        else if(type==2) printf("\t|-MTU               : %u\n", rest);
+        else if(type==135 || type==136) { // NS/NA carry a target address after the 4 byte (flags) field
+            struct in6_addr target; char tgt[INET6_ADDRSTRLEN];
+            read_in6(fp, &target);
+            l4_header_len += 16;
+            if(type==136) printf("\t|-Flags => |Router:%d|Solicited:%d|Override:%d|\n",
+                                 (rest >> 31) & 1, (rest >> 30) & 1, (rest >> 29) & 1);
+            printf("\t|-Target Address    : %s\n", inet_ntop(AF_INET6, &target, tgt, sizeof(tgt)));
+        }
+    }
+    else if (l4_proto == IPPROTO_NONE) {
+        printf("[No L4 Header] (non-first fragment or IPv6 No-Next-Header)\n");
+    }
 
     // --- 4. Final Payload ---
-    int payload_len = ip.len - ip_hdr_bytes - l4_header_len - app_header_len;
+    int payload_len = l3_payload_len - (int)l4_header_len - (int)app_header_len;
     if (payload_len > 0) {
         printf("[Payload (%d bytes)]\n  \"", payload_len);
         for(int i = 0; i < payload_len; i++) {
@@ -261,6 +388,7 @@ int main(int argc, char *argv[]) {
     FILE *fp = fopen(argv[1], "r");
     if (!fp) return perror("File error"), 1;
 
+    arp_cache_init(&arp_cache);
     uint peek;
     while (fscanf(fp, "%2x", &peek) == 1) {
         fseek(fp, -2, SEEK_CUR); // Back up so process_packet can read the full byte
@@ -268,5 +396,7 @@ int main(int argc, char *argv[]) {
     }
 
     fclose(fp);
+    arp_cache_report(&arp_cache, 0);
+    arp_cache_free(&arp_cache);
     return 0;
 }
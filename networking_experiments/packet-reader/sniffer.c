@@ -1,7 +1,18 @@
 // gcc sniffer.c -lpcap
 // to read pcap files
-#define _DEFAULT_SOURCE  // Enables BSD-style struct definitions on Linux
+// ./a.out [-L] [-S] [-o decoded.col] [-w out.pcap [-s snaplen] [-V vlan] [-F "bpf filter"] [-D]] <packet_file.pcap>
+//   -L : list the registered protocol dissectors and exit
+//   -S : statistics only (see capture_stats.h), no per-packet decode/print: protocol hierarchy,
+//        packet sizes, VLANs, top IPs and rates at exit
+//   -o : write decoded metadata to a columnar binary file (see columnar_out.h) instead of printing
+//   -w : write a reduced capture (see pcap_writer.h) instead of printing, selected packets only:
+//        -s truncates every packet to snaplen bytes, -V keeps only frames tagged with that VLAN id,
+//        -F keeps only packets matching a tcpdump style filter, -D writes with O_DIRECT
+// gcc -DSTAGE_TIMING sniffer.c -lpcap  => per decode stage latency histograms at exit (stage_timing.h)
+#define _GNU_SOURCE  // Enables BSD-style struct definitions (+ O_DIRECT) on Linux
 #include <stdio.h>
+#include <unistd.h>          // getopt()
+#include <time.h>            // clock_gettime() for the -S processing rate
 #include <pcap.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>      // Required for IP address structures
@@ -12,22 +23,675 @@
 #include <netinet/udp.h>      // For L4 UDP
 #include <netinet/ip_icmp.h>  // For ICMP structs
 #include <netinet/igmp.h>     // For IGMP structs
+#include <netinet/ip6.h>      // For L3 IPv6 & extension headers
+#include <netinet/icmp6.h>    // For ICMPv6 / NDP structs
+#include "flow_table.h"       // Flow accounting keyed for both IPv4 & IPv6
+#include "dns_decoder.h"      // DNS sections + query/response latency tracking
+#include "columnar_out.h"     // struct pkt_meta + columnar binary writer
+#include "checksum.h"         // IP/TCP/UDP/ICMP checksum verification
+#include "pcap_writer.h"      // reduced capture output
+#include "arp_cache.h"        // IP->MAC bindings + gratuitous/duplicate/spoof detection
+#include "igmp_snoop.h"       // (VLAN, group) -> member ports
+#include "stage_timing.h"     // -DSTAGE_TIMING only
+#include "dissector.h"        // EtherType / IP protocol / port -> decoder tables
+#include "capture_stats.h"    // -S aggregate statistics
 
 #define ETHERTYPE_QINQ 0x88a8 // not defined in std libs
 #define header_scale 4 // header length field scale for ip and tcp
 #define fragment_scale 8 // fragment offset field scale for ip
+#define ipv6_ext_scale 8 // extension header length field scale for ipv6 (excluding first 8 bytes)
+#define IPV6_MAX_EXT_HDRS 8 // bound on the extension header chain walk
 
 static uint n = 0;
-void process_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
-    printf("\n=== PACKET FRAME %d ===\n", ++n);
+static struct flow_table flows;
+static struct dns_tracker dns;
+static int print_packets = 1; // 0 => per-packet text output is skipped entirely
+static struct col_writer col_out;
+static int col_enabled = 0;
+static struct csum_stats csum;
+static struct arp_cache arp_cache;
+static struct igmp_snoop igmp_snoop;
+static uint64_t last_ts_us = 0; // capture time of the latest frame (ages the ARP cache in the report)
+static struct pcap_writer pcap_out;
+static int pcap_out_enabled = 0;
+static struct bpf_program out_filter; // -F
+static int out_filter_enabled = 0;
+static int out_vlan = -1;             // -V, -1 = any
+static int stats_enabled = 0;         // -S
+static int decode_enabled = 1;        // 0 => -S alone, frames are only counted
+static struct cap_stats cap_stats;    // decoding thread's shard (the only one, pcap_loop is single threaded)
+
+// A capture has no ingress port: every host gets a stable simulated port 1..IGMP_MAX_PORTS
+// from its MAC (same numbering as the MAC learner, which picks them at random)
+static uint snoop_port(const uint8_t *mac) {
+    uint32_t h = 0;
+    for (int i = 0; i < 6; i++) h = h * 31 + mac[i];
+    return h % IGMP_MAX_PORTS + 1;
+}
+
+// printf() for per-packet output: the arguments are not even evaluated when printing is off
+#define show(...) do { if (print_packets) printf(__VA_ARGS__); } while (0)
+
+// Print NDP options (type-length-value, length in units of 8 bytes) between opt & end
+void print_ndp_options(const u_char *opt, const u_char *end) {
+    while (opt + 2 <= end) {
+        uint opt_len = opt[1] * 8;
+        if (opt_len == 0 || opt + opt_len > end) {
+            show("\t[NDP Option] Malformed option length, stopping\n");
+            return;
+        }
+        switch (opt[0]) {
+            case ND_OPT_SOURCE_LINKADDR:
+            case ND_OPT_TARGET_LINKADDR:
+                show("\t[NDP Option] %s Link-Layer Addr : %02X:%02X:%02X:%02X:%02X:%02X\n",
+                       (opt[0] == ND_OPT_SOURCE_LINKADDR) ? "Source" : "Target",
+                       opt[2], opt[3], opt[4], opt[5], opt[6], opt[7]);
+                break;
+            case ND_OPT_PREFIX_INFORMATION: {
+                struct nd_opt_prefix_info *pi = (struct nd_opt_prefix_info *)opt;
+                char prefix[INET6_ADDRSTRLEN];
+                inet_ntop(AF_INET6, &pi->nd_opt_pi_prefix, prefix, sizeof(prefix));
+                show("\t[NDP Option] Prefix : %s/%d |On-Link:%d|Autonomous:%d|Valid:%us|Preferred:%us|\n",
+                       prefix, pi->nd_opt_pi_prefix_len,
+                       (pi->nd_opt_pi_flags_reserved & ND_OPT_PI_FLAG_ONLINK) ? 1 : 0,
+                       (pi->nd_opt_pi_flags_reserved & ND_OPT_PI_FLAG_AUTO) ? 1 : 0,
+                       ntohl(pi->nd_opt_pi_valid_time), ntohl(pi->nd_opt_pi_preferred_time));
+                break;
+            }
+            case ND_OPT_MTU:
+                show("\t[NDP Option] MTU : %u\n", ntohl(((struct nd_opt_mtu *)opt)->nd_opt_mtu_mtu));
+                break;
+            default:
+                show("\t[NDP Option] Type:%d Length:%d Bytes\n", opt[0], opt_len);
+                break;
+        }
+        opt += opt_len;
+    }
+}
+
+// Walk the IPv6 extension header chain that follows the 40 byte fixed header.
+// Returns the full L3 header length (fixed + extensions) and stores the upper layer
+// protocol in *l4_proto; *frag_offset gets the fragment offset if a Fragment header is found
+// and *fragmented is set for any fragment (first one included).
+// The walk is bounded both by the captured length and by IPV6_MAX_EXT_HDRS.
+uint walk_ipv6_ext_headers(const u_char *l3_start, uint avail, uint8_t *l4_proto, uint *frag_offset, int *fragmented) {
+    const struct ip6_hdr *ip6 = (const struct ip6_hdr *)l3_start;
+    uint8_t next = ip6->ip6_nxt;
+    uint offset = sizeof(struct ip6_hdr);
+    *frag_offset = 0;
+    *fragmented = 0;
+
+    for (int hops = 0; hops < IPV6_MAX_EXT_HDRS; hops++) {
+        if (next != IPPROTO_HOPOPTS && next != IPPROTO_ROUTING && next != IPPROTO_FRAGMENT &&
+            next != IPPROTO_DSTOPTS && next != IPPROTO_AH)
+            break; // reached the upper layer protocol (or No Next Header)
+
+        if (offset + 8 > avail) { // every extension header is at least 8 bytes
+            show("\t[Ext Header] Truncated extension header chain!\n");
+            next = IPPROTO_NONE;
+            break;
+        }
+        const struct ip6_ext *ext = (const struct ip6_ext *)(l3_start + offset);
+        uint ext_len = (ext->ip6e_len + 1) * ipv6_ext_scale;
+
+        switch (next) {
+            case IPPROTO_HOPOPTS:
+                show("\t[Ext Header] Hop-by-Hop Options => |Length:%d Bytes|\n", ext_len);
+                break;
+            case IPPROTO_DSTOPTS:
+                show("\t[Ext Header] Destination Options => |Length:%d Bytes|\n", ext_len);
+                break;
+            case IPPROTO_ROUTING: {
+                const struct ip6_rthdr *rt = (const struct ip6_rthdr *)ext;
+                show("\t[Ext Header] Routing => |Length:%d Bytes|Type:%d|Segments-Left:%d|\n",
+                       ext_len, rt->ip6r_type, rt->ip6r_segleft);
+                break;
+            }
+            case IPPROTO_FRAGMENT: {
+                const struct ip6_frag *frag = (const struct ip6_frag *)ext;
+                uint16_t offlg = ntohs(frag->ip6f_offlg);
+                ext_len = sizeof(struct ip6_frag); // fixed size, length field is reserved
+                *frag_offset = (offlg >> 3) * fragment_scale; // same 8 byte units as IPv4
+                *fragmented = 1;
+                show("\t[Ext Header] Fragment => |Offset:%d|More-Fragments:%d|Identification:0x%08X|\n",
+                       *frag_offset, offlg & 0x1, ntohl(frag->ip6f_ident));
+                break;
+            }
+            case IPPROTO_AH:
+                ext_len = (ext->ip6e_len + 2) * header_scale; // AH length is in 4 byte units minus 2
+                show("\t[Ext Header] Authentication => |Length:%d Bytes|\n", ext_len);
+                break;
+        }
+        next = ext->ip6e_nxt;
+        offset += ext_len;
+    }
+    *l4_proto = next;
+    return offset;
+}
+
+// Verify an L4 checksum; 'proto' != 0 adds the TCP/UDP/ICMPv6 pseudo header
+// (addresses already summed into pseudo_sum, protocol & length added here).
+// Returns the tag printed next to the checksum field.
+const char *verify_l4_checksum(enum csum_proto p, const u_char *l4, uint l4_len, int complete,
+                               uint64_t pseudo_sum, uint8_t proto) {
+    if (!complete) return csum_skip(&csum, p);
+    uint64_t sum = proto ? pseudo_sum + htons(proto) + htons((uint16_t)l4_len) : 0;
+    return csum_record(&csum, p, csum_add(l4, l4_len, sum));
+}
+
+// State handed from one dissector to the next while a frame is decoded
+struct dissect_ctx {
+    const struct pcap_pkthdr *header;
+    const u_char *packet;
+    struct pkt_meta *meta;
+    const struct ether_header *eth;
+    uint eth_header_len;  // Ethernet + VLAN tags = L3 offset
+    uint16_t eth_type;    // innermost EtherType
+
+    // Common L3 results, so L4 decode & flow accounting are identical for IPv4 and IPv6
+    struct flow_key flow;
+    uint8_t l4_proto;     // upper layer protocol (after any IPv6 extension headers)
+    uint l3_header_len;   // IPv4 header / IPv6 fixed header + extension headers
+    uint l3_frag_offset;  // non-zero => no L4 header in this fragment
+    uint l4_len;          // L4 header + data length as announced by L3
+    int l4_complete;      // whole L4 segment captured & unfragmented => checksum can be verified
+    uint64_t pseudo_sum;  // one's complement sum of the pseudo header addresses
+
+    const u_char *l4_start;
+    uint l4_header_len;   // set by the L4 dissector, the payload follows it
+};
+
+// L3^ ARP & RARP Handling
+static int dissect_arp(struct dissect_ctx *c) {
+    const struct pcap_pkthdr *header = c->header;
+    struct pkt_meta *meta = c->meta;
+    struct arphdr *arp = (struct arphdr *)(c->packet + c->eth_header_len);
+
+    show("[%s Header]\n", (c->eth_type == ETHERTYPE_ARP) ? "ARP" : "RARP");
+    show("\t|-Hardware Type     : %d (Ethernet=1)\n", ntohs(arp->ar_hrd));
+    show("\t|-Protocol Type     : 0x%04X (IPv4=0800)\n", ntohs(arp->ar_pro));
+    show("\t|-Hardware Size     : %d\n", arp->ar_hln);
+    show("\t|-Protocol Size     : %d\n", arp->ar_pln);
+
+    uint16_t op = ntohs(arp->ar_op);
+    show("\t|-Opcode            : %d ", op);
+    if(op == ARPOP_REQUEST) show("(ARP Request)\n");
+    else if(op == ARPOP_REPLY) show("(ARP Reply)\n");
+    else if(op == ARPOP_RREQUEST) show("(RARP Request)\n");
+    else if(op == ARPOP_RREPLY) show("(RARP Reply)\n");
+    else show("(Unknown)\n");
+
+    // ARP/RARP addresses follow the fixed header
+    unsigned char *sha = (unsigned char *)(arp + 1);            // Sender Hardware Address
+    unsigned char *spa = sha + arp->ar_hln;                     // Sender Protocol Address
+    unsigned char *tha = spa + arp->ar_pln;                     // Target Hardware Address
+    unsigned char *tpa = tha + arp->ar_hln;                     // Target Protocol Address
+
+    show("\t|-Sender MAC        : %02X:%02X:%02X:%02X:%02X:%02X\n", sha[0],sha[1],sha[2],sha[3],sha[4],sha[5]);
+    show("\t|-Sender IP         : %d.%d.%d.%d\n", spa[0], spa[1], spa[2], spa[3]);
+    show("\t|-Target MAC        : %02X:%02X:%02X:%02X:%02X:%02X\n", tha[0],tha[1],tha[2],tha[3],tha[4],tha[5]);
+    show("\t|-Target IP         : %d.%d.%d.%d\n", tpa[0], tpa[1], tpa[2], tpa[3]);
+
+    // Only Ethernet/IPv4 ARP (not RARP) carries bindings worth caching
+    if (c->eth_type == ETHERTYPE_ARP && ntohs(arp->ar_hrd) == ARPHRD_ETHER && ntohs(arp->ar_pro) == ETHERTYPE_IP &&
+        arp->ar_hln == 6 && arp->ar_pln == 4 && (op == ARPOP_REQUEST || op == ARPOP_REPLY) &&
+        c->eth_header_len + sizeof(struct arphdr) + 20 <= header->caplen) {
+        uint32_t sip, tip;
+        memcpy(&sip, spa, 4);
+        memcpy(&tip, tpa, 4);
+        enum arp_verdict v = arp_cache_observe(&arp_cache, meta->ts_us, meta->inner_vid, op,
+                                               c->eth->ether_shost, sha, sip, tip);
+        show("\t|-ARP Cache         : %s\n", arp_verdict_names[v]);
+    }
+    STAGE_MARK(STAGE_ARP);
+    return 0; // Finished processing ARP/RARP
+}
+
+static int dissect_unknown_ethertype(struct dissect_ctx *c) {
+    (void)c;
+    show("Unknown EtherType! Valid types = IPv4:%04X, IPv6:%04X, skipping unpacking further...\n",
+           ETHERTYPE_IP, ETHERTYPE_IPV6);
+    return -1;
+}
+
+// L5&6 Final Payload
+static void print_payload(struct dissect_ctx *c) {
+    uint total_headers = c->eth_header_len + c->l3_header_len + c->l4_header_len;
+    const u_char *payload = c->packet + total_headers;
+    uint payload_len = (c->header->caplen > total_headers) ? c->header->caplen - total_headers : 0;
+    c->meta->payload_offset = total_headers;
+    c->meta->payload_len = payload_len;
+    if (!print_packets) return;
+
+    if (payload_len > 0) {
+        show("[Payload (%d bytes)]\n  \"", payload_len);
+        for(int i = 0; i < payload_len; i++) {
+            if(payload[i] >= 32 && payload[i] <= 126) show("%c", payload[i]);
+            else show("."); // Print non-printable chars as dots
+        }
+        show("\"\n");
+    } else {
+        show("[No Payload Found]\n");
+    }
+    STAGE_MARK(STAGE_PAYLOAD);
+}
+
+// Shared by the IPv4 & IPv6 dissectors once the common L3 results are filled in
+static int dissect_transport(struct dissect_ctx *c) {
+    struct pkt_meta *meta = c->meta;
+    c->l4_header_len = 0;
+    c->l4_start = c->packet + c->eth_header_len + c->l3_header_len;
+    if (c->l3_frag_offset != 0) c->l4_proto = IPPROTO_NONE; // later fragments carry no L4 header
+    STAGE_MARK(STAGE_L3);
+
+    // Flow accounting (TCP & UDP share the port layout of their first 4 bytes)
+    c->flow.proto = c->l4_proto;
+    if (c->l4_proto == IPPROTO_TCP || c->l4_proto == IPPROTO_UDP) {
+        c->flow.sport = ntohs(*(uint16_t *)c->l4_start);
+        c->flow.dport = ntohs(*(uint16_t *)(c->l4_start + 2));
+    }
+    flow_table_update(&flows, &c->flow, c->header->len);
+    memcpy(meta->src, c->flow.src, sizeof(meta->src));
+    memcpy(meta->dst, c->flow.dst, sizeof(meta->dst));
+    meta->family = c->flow.family;
+    meta->proto = c->flow.proto;
+    meta->sport = c->flow.sport;
+    meta->dport = c->flow.dport;
+    meta->l4_offset = c->eth_header_len + c->l3_header_len;
+    if (c->l3_frag_offset != 0) meta->ip_flags |= 0x4;
+    STAGE_MARK(STAGE_FLOW);
+
+    // Layer 4: Transport Layer || Control Layer (table lookup on l4_proto)
+    if (dissect(DISSECT_IP_PROTO, c->l4_proto, c) < 0) return -1;
+    STAGE_MARK(STAGE_L4);
+    print_payload(c);
+    return 0;
+}
+
+static int dissect_ipv6(struct dissect_ctx *c) {
+    // Layer 3: IPv6 Header
+    struct ip6_hdr *ip6 = (struct ip6_hdr *)(c->packet + c->eth_header_len);
+    if (c->header->caplen < c->eth_header_len + sizeof(struct ip6_hdr)) {
+        show("[L3 IPv6] Truncated header, skipping unpacking further...\n");
+        return -1;
+    }
+    uint32_t vtc_flow = ntohl(ip6->ip6_flow);
+    char src6[INET6_ADDRSTRLEN], dst6[INET6_ADDRSTRLEN];
+    if (print_packets) {
+        inet_ntop(AF_INET6, &ip6->ip6_src, src6, sizeof(src6));
+        inet_ntop(AF_INET6, &ip6->ip6_dst, dst6, sizeof(dst6));
+    }
+
+    show("[L3 IPv6]\n");
+    show("\t|-IP Version        : %d\n", vtc_flow >> 28); // first 4 bits
+    show("\t|-Traffic Class     : %d\n", (vtc_flow >> 20) & 0xFF); // next 8 bits (DSCP + ECN)
+    show("\t|-Flow Label        : 0x%05X\n", vtc_flow & 0xFFFFF); // last 20 bits
+    show("\t|-Payload Length    : %d Bytes\n", ntohs(ip6->ip6_plen));
+    show("\t|-Next Header       : %d\n", ip6->ip6_nxt);
+    show("\t|-Hop Limit         : %d\n", ip6->ip6_hlim);
+    show("\t|-Source IP         : %s\n", src6);
+    show("\t|-Destination IP    : %s\n", dst6);
+
+    int fragmented;
+    c->l3_header_len = walk_ipv6_ext_headers((const u_char *)ip6, c->header->caplen - c->eth_header_len,
+                                             &c->l4_proto, &c->l3_frag_offset, &fragmented);
+    flow_key_v6(&c->flow, &ip6->ip6_src, &ip6->ip6_dst);
+    uint ip6_len = sizeof(struct ip6_hdr) + ntohs(ip6->ip6_plen);
+    // extension headers claiming more than the payload length => nothing left for L4
+    c->l4_len = (c->l3_header_len <= ip6_len) ? ip6_len - c->l3_header_len : 0;
+    c->l4_complete = !fragmented && c->l3_header_len <= ip6_len &&
+                     c->eth_header_len + c->l3_header_len + c->l4_len <= c->header->caplen;
+    c->pseudo_sum = csum_add(&ip6->ip6_src, 32, 0); // src + dst
+    c->meta->ttl = ip6->ip6_hlim;
+    return dissect_transport(c);
+}
+
+static int dissect_ipv4(struct dissect_ctx *c) {
+    // Layer 3: IPv4 Header (Adjusted offset for possible VLAN tag)
+    struct ip *ip = (struct ip *)(c->packet + c->eth_header_len);
+    uint ip_header_len = ip->ip_hl * header_scale;
+    uint16_t ip_frag_off_field = ntohs(ip->ip_off); 
+    uint ip_fragment_offset = (ip_frag_off_field & IP_OFFMASK) * fragment_scale;
+    show("[L3 IPv4]\n");
+    show("\t|-IP Version        : %d\n", (uint)ip->ip_v);
+
+    show("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n",
+            (uint)ip->ip_hl, header_scale, ip_header_len);
+
+    show("\t|-Type Of Service   : %d\n", (uint)ip->ip_tos);
+    show("\t|-Total Length      : %d Bytes\n", ntohs(ip->ip_len));
+    show("\t|-Identification    : %d\n", ntohs(ip->ip_id));
+
+    show("\t[Flags] => |Reserved-Bit:%d|Dont-Fragment:%d|More-Fragments:%d|\n", 
+        (ip_frag_off_field& IP_RF) >> 15, (ip_frag_off_field & IP_DF) >> 14, (ip_frag_off_field & IP_MF) >> 13);
+
+    show("\t|-Fragment Offset  => Offset:%d * ScalingFactor:%d = %d\n",
+            (uint)(ip_frag_off_field & IP_OFFMASK), fragment_scale, ip_fragment_offset);
+
+    show("\t|-TTL               : %d\n", (uint)ip->ip_ttl);
+    show("\t|-Protocol          : %d\n", (uint)ip->ip_p);
+    const char *ip_csum_status = (c->eth_header_len + ip_header_len <= c->header->caplen)
+        ? csum_record(&csum, CSUM_IPV4, csum_add(ip, ip_header_len, 0)) : csum_skip(&csum, CSUM_IPV4);
+    show("\t|-Header Checksum   : %d %s\n", ntohs(ip->ip_sum), ip_csum_status);
+    show("\t|-Source IP         : %s\n", inet_ntoa(ip->ip_src));
+    show("\t|-Destination IP    : %s\n", inet_ntoa(ip->ip_dst));
+
+    c->l4_proto = ip->ip_p;
+    c->l3_header_len = ip_header_len;
+    c->l3_frag_offset = ip_fragment_offset;
+    flow_key_v4(&c->flow, &ip->ip_src, &ip->ip_dst);
+    c->meta->ttl = ip->ip_ttl;
+    c->l4_len = ntohs(ip->ip_len) - ip_header_len;
+    c->l4_complete = !(ip_frag_off_field & (IP_MF | IP_OFFMASK)) && c->eth_header_len + ip_header_len + c->l4_len <= c->header->caplen;
+    c->pseudo_sum = csum_add(&ip->ip_src, 8, 0); // src + dst
+    c->meta->ip_flags = ((ip_frag_off_field & IP_MF) ? 0x1 : 0) | ((ip_frag_off_field & IP_DF) ? 0x2 : 0);
+    return dissect_transport(c);
+}
+
+static int dissect_tcp(struct dissect_ctx *c) {
+    struct tcphdr *tcp = (struct tcphdr *)c->l4_start;
+    c->l4_header_len = tcp->doff * header_scale;
+    c->meta->tcp_flags = tcp->th_flags;
+    show("[L4 TCP]\n");
+    show("\t|-Source Port       : %u\n", ntohs(tcp->source));
+    show("\t|-Destination Port  : %u\n", ntohs(tcp->dest));
+    show("\t|-Sequence No.      : %u\n", ntohl(tcp->seq));
+    show("\t|-Acknowledge No.   : %u\n", ntohl(tcp->ack_seq));
+
+    show("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n",
+            (uint)tcp->doff, header_scale, c->l4_header_len);
+
+    show("\t|-Flags => |URG:%d|ACK:%d|PSH:%d|RST:%d|SYN:%d|FIN:%d|\n", 
+            (tcp->th_flags & TH_URG) ? 1 : 0, (tcp->th_flags & TH_ACK) ? 1 : 0, (tcp->th_flags & TH_PUSH) ? 1 : 0,
+            (tcp->th_flags & TH_RST) ? 1 : 0, (tcp->th_flags & TH_SYN) ? 1 : 0, (tcp->th_flags & TH_FIN) ? 1 : 0);
+    
+    show("\t|-Window Size       : %d\n", ntohs(tcp->window));
+    const char *csum_status = verify_l4_checksum(CSUM_TCP, c->l4_start, c->l4_len, c->l4_complete, c->pseudo_sum, IPPROTO_TCP);
+    show("\t|-Checksum          : %d %s\n", ntohs(tcp->check), csum_status);
+    show("\t|-Urgent Pointer    : %d\n", tcp->urg_ptr);
+    return dissect_ports(DISSECT_TCP_PORT, c->flow.sport, c->flow.dport, c) < 0 ? -1 : 0;
+}
+
+static int dissect_icmp(struct dissect_ctx *c) {
+    struct icmphdr *icmp = (struct icmphdr *)c->l4_start;
+    c->l4_header_len = 8; // ICMP header is 8 bytes
+    show("[L4 ICMP]\n");
+    
+    // 1. Basic ICMP Fields
+    show("\t|-Type     : %d ", icmp->type);
+    
+    // Decoding the Type
+    switch(icmp->type) {
+        case ICMP_ECHOREPLY:     show("(Echo Reply)\n"); break;
+        case ICMP_DEST_UNREACH:  show("(Destination Unreachable)\n"); break;
+        case ICMP_REDIRECT:      show("(Redirect / Routing Error)\n"); break;
+        case ICMP_ECHO:          show("(Echo Request)\n"); break;
+        case ICMP_TIME_EXCEEDED: show("(Time Exceeded / TTL Expired)\n"); break;
+        default:                 show("(Other / Feedback)\n"); break;
+    }
+
+    show("\t|-Code     : %d\n", (uint)icmp->code);
+    const char *csum_status = verify_l4_checksum(CSUM_ICMP, c->l4_start, c->l4_len, c->l4_complete, 0, 0); // no pseudo header
+    show("\t|-Checksum : %d %s\n", ntohs(icmp->checksum), csum_status);
+
+    // 2. Specialized Format Handling
+    // Echo Request/Reply (Ping)
+    if (icmp->type == ICMP_ECHO || icmp->type == ICMP_ECHOREPLY) {
+        show("\t|-Identifier : %d\n", ntohs(icmp->un.echo.id));
+        show("\t|-Sequence   : %d\n", ntohs(icmp->un.echo.sequence));
+    } 
+    // Gateway Redirect
+    else if (icmp->type == ICMP_REDIRECT) {
+        struct in_addr gw;
+        gw.s_addr = icmp->un.gateway;
+        show("\t|-Gateway Addr: %s\n", inet_ntoa(gw));
+    }
+    // Error handling (Destination Unreachable / Time Exceeded)
+    else if (icmp->type == ICMP_DEST_UNREACH || icmp->type == ICMP_TIME_EXCEEDED) {
+        show("\t|-Next-Hop MTU: %d (if applicable)\n", ntohs(icmp->un.frag.mtu));
+        show("\t[Note] This packet contains a copy of the original failed IP header.\n");
+    }
+    return 0;
+}
+
+static int dissect_igmp(struct dissect_ctx *c) {
+    const u_char *l4_start = c->l4_start;
+    struct igmp *igmp = (struct igmp *)l4_start;
+    c->l4_header_len = 8;
+    show("[L4 IGMP]\n");
+    
+    show("\t|-Type              : 0x%02X ", igmp->igmp_type);
+    switch(igmp->igmp_type) {
+        case IGMP_MEMBERSHIP_QUERY:     show("(Membership Query)\n"); break;
+        case IGMP_V1_MEMBERSHIP_REPORT: show("(v1 Membership Report)\n"); break;
+        case IGMP_V2_MEMBERSHIP_REPORT: show("(v2 Membership Report)\n"); break;
+        case IGMP_V2_LEAVE_GROUP:       show("(Leave Group)\n"); break;
+        case 0x22:                      show("(v3 Membership Report)\n"); break;
+        default:                        show("(Unknown IGMP Type)\n"); break;
+    }
+
+    show("\t|-Max Response Time : %d\n", igmp->igmp_code);
+    const char *csum_status = verify_l4_checksum(CSUM_IGMP, l4_start, c->l4_len, c->l4_complete, 0, 0);
+    show("\t|-Checksum          : %d %s\n", ntohs(igmp->igmp_cksum), csum_status);
+
+    const u_char *end = c->packet + c->header->caplen;
+    uint igmp_len = c->l4_len; // clipped to what was captured, 0 if the capture ends before L4
+    if (l4_start >= end) igmp_len = 0;
+    else if (igmp_len > (uint)(end - l4_start)) igmp_len = end - l4_start;
+    if (igmp->igmp_type == IGMP_V3_REPORT && igmp_len >= 8) { // no group field, a list of group records instead
+        uint n_rec = l4_start[6] << 8 | l4_start[7], off = 8;
+        show("\t|-Group Records     : %u\n", n_rec);
+        for (uint r = 0; r < n_rec && off + 8 <= igmp_len; r++) {
+            uint n_src = l4_start[off + 2] << 8 | l4_start[off + 3];
+            show("\t[Group Record #%u] Type:%d Group:%s Sources:%u\n", r + 1, l4_start[off],
+                 inet_ntoa(*(struct in_addr *)(l4_start + off + 4)), n_src);
+            off += 8 + 4 * n_src + 4 * l4_start[off + 1];
+        }
+    } else {
+        show("\t|-Group Address     : %s\n", inet_ntoa(igmp->igmp_group));
+    }
+    uint port = snoop_port(c->eth->ether_shost);
+    igmp_snoop_packet(&igmp_snoop, c->header->ts.tv_sec, c->meta->inner_vid, port, l4_start, igmp_len);
+    show("\t|-Snooping Port     : %u (simulated)\n", port);
+    return 0;
+}
+
+static int dissect_udp(struct dissect_ctx *c) {
+    struct udphdr *udp = (struct udphdr *)c->l4_start;
+    c->l4_header_len = 8; // UDP is always 8 bytes
+    uint16_t src_port = ntohs(udp->source);
+    uint16_t dst_port = ntohs(udp->dest);
+    show("[L4 UDP]\n");
+    show("\t|-Source Port       : %u\n", src_port);
+    show("\t|-Destination Port  : %u\n", dst_port);
+    show("\t|-UDP Length        : %u\n", ntohs(udp->len));
+    // UDP over IPv4 may omit the checksum (0), over IPv6 it is mandatory
+    const char *csum_status = (udp->check == 0 && c->flow.family == AF_INET)
+        ? csum_skip(&csum, CSUM_UDP)
+        : verify_l4_checksum(CSUM_UDP, c->l4_start, c->l4_len, c->l4_complete, c->pseudo_sum, IPPROTO_UDP);
+    show("\t|-Checksum          : %d %s\n", ntohs(udp->check), csum_status);
+
+    // L7 by port (table lookup, e.g. 53 => DNS)
+    return dissect_ports(DISSECT_UDP_PORT, src_port, dst_port, c) < 0 ? -1 : 0;
+}
+
+// --- DNS Handling --- (UDP port 53)
+static int dissect_dns(struct dissect_ctx *c) {
+    const struct pcap_pkthdr *header = c->header;
+    const u_char *dns_start = c->l4_start + c->l4_header_len;
+    const u_char *end = c->packet + header->caplen;
+    if (dns_start >= end) return 0; // capture ends before the DNS message
+    // DNS length = UDP length - header, clipped to what was actually captured
+    uint udp_len = ntohs(((struct udphdr *)c->l4_start)->len);
+    uint dns_len = (udp_len > c->l4_header_len) ? udp_len - c->l4_header_len : 0;
+    if (dns_len > (uint)(end - dns_start)) dns_len = end - dns_start;
+    if (dns_len < 12) { // not even the fixed header
+        show("[L7 DNS] Truncated header (%u bytes)\n", dns_len);
+        return 0;
+    }
+    show("[L7 DNS Header]\n");
+    show("\t|-Transaction ID    : 0x%04X\n", ntohs(*(uint16_t*)(dns_start)));
+    
+    uint16_t flags = ntohs(*(uint16_t*)(dns_start + 2));
+    show("\t|-Flags             : 0x%04X ", flags);
+    show("(%s)\n", (flags & 0x8000) ? "Response" : "Query");
+
+    show("\t|-Questions         : %u\n", ntohs(*(uint16_t*)(dns_start + 4)));
+    show("\t|-Answer RRs        : %u\n", ntohs(*(uint16_t*)(dns_start + 6)));
+    show("\t|-Authority RRs     : %u\n", ntohs(*(uint16_t*)(dns_start + 8)));
+    show("\t|-Additional RRs    : %u\n", ntohs(*(uint16_t*)(dns_start + 10)));
+
+    STAGE_MARK(STAGE_L4);
+    if (print_packets) dns_print_message(dns_start, dns_len);
+    dns_track(&dns, &c->flow, (uint64_t)header->ts.tv_sec * 1000000 + header->ts.tv_usec, dns_start, dns_len);
+    STAGE_MARK(STAGE_DNS);
+    return 0;
+}
+
+static int dissect_icmpv6(struct dissect_ctx *c) {
+    const u_char *l4_start = c->l4_start;
+    struct icmp6_hdr *icmp6 = (struct icmp6_hdr *)l4_start;
+    uint l4_header_len = 8; // generic ICMPv6 header is 8 bytes, NDP messages extend it below
+    show("[L4 ICMPv6]\n");
+    show("\t|-Type     : %d ", icmp6->icmp6_type);
+
+    switch (icmp6->icmp6_type) {
+        case ICMP6_DST_UNREACH:    show("(Destination Unreachable)\n"); break;
+        case ICMP6_PACKET_TOO_BIG: show("(Packet Too Big)\n"); break;
+        case ICMP6_TIME_EXCEEDED:  show("(Time Exceeded / Hop Limit Expired)\n"); break;
+        case ICMP6_PARAM_PROB:     show("(Parameter Problem)\n"); break;
+        case ICMP6_ECHO_REQUEST:   show("(Echo Request)\n"); break;
+        case ICMP6_ECHO_REPLY:     show("(Echo Reply)\n"); break;
+        case ND_ROUTER_SOLICIT:    show("(NDP Router Solicitation)\n"); break;
+        case ND_ROUTER_ADVERT:     show("(NDP Router Advertisement)\n"); break;
+        case ND_NEIGHBOR_SOLICIT:  show("(NDP Neighbor Solicitation)\n"); break;
+        case ND_NEIGHBOR_ADVERT:   show("(NDP Neighbor Advertisement)\n"); break;
+        case ND_REDIRECT:          show("(NDP Redirect)\n"); break;
+        case 143:                  show("(MLDv2 Listener Report)\n"); break;
+        default:                   show("(Other / Informational)\n"); break;
+    }
+    show("\t|-Code     : %d\n", icmp6->icmp6_code);
+    const char *csum_status = verify_l4_checksum(CSUM_ICMPV6, l4_start, c->l4_len, c->l4_complete, c->pseudo_sum, IPPROTO_ICMPV6);
+    show("\t|-Checksum : %d %s\n", ntohs(icmp6->icmp6_cksum), csum_status);
+
+    char addr6[INET6_ADDRSTRLEN];
+    const u_char *l4_end = c->packet + c->header->caplen;
+    // the fixed part of the message is read below, so it has to be captured in full (e.g. -w -s 60)
+    size_t fixed_len = icmp6->icmp6_type == ND_ROUTER_ADVERT    ? sizeof(struct nd_router_advert) :
+                       icmp6->icmp6_type == ND_NEIGHBOR_SOLICIT ? sizeof(struct nd_neighbor_solicit) :
+                       icmp6->icmp6_type == ND_NEIGHBOR_ADVERT  ? sizeof(struct nd_neighbor_advert) :
+                       icmp6->icmp6_type == ND_REDIRECT         ? sizeof(struct nd_redirect) :
+                       icmp6->icmp6_type == ICMP6_ECHO_REQUEST || icmp6->icmp6_type == ICMP6_ECHO_REPLY ||
+                       icmp6->icmp6_type == ICMP6_PACKET_TOO_BIG ? sizeof(struct icmp6_hdr) : 0;
+    if (fixed_len && l4_start + fixed_len > l4_end) {
+        uint have = l4_start < l4_end ? l4_end - l4_start : 0;
+        show("\t[L4 ICMPv6] Truncated message (%u of %zu bytes), skipping unpacking further...\n", have, fixed_len);
+        c->l4_header_len = have;
+        return 0;
+    }
+    if (icmp6->icmp6_type == ICMP6_ECHO_REQUEST || icmp6->icmp6_type == ICMP6_ECHO_REPLY) {
+        show("\t|-Identifier : %d\n", ntohs(icmp6->icmp6_id));
+        show("\t|-Sequence   : %d\n", ntohs(icmp6->icmp6_seq));
+    }
+    else if (icmp6->icmp6_type == ICMP6_PACKET_TOO_BIG) {
+        show("\t|-MTU        : %u\n", ntohl(icmp6->icmp6_mtu));
+    }
+    else if (icmp6->icmp6_type == ICMP6_DST_UNREACH || icmp6->icmp6_type == ICMP6_TIME_EXCEEDED ||
+             icmp6->icmp6_type == ICMP6_PARAM_PROB) {
+        show("\t[Note] This packet contains a copy of the original failed IPv6 packet.\n");
+    }
+    else if (icmp6->icmp6_type == ND_ROUTER_SOLICIT) {
+        print_ndp_options(l4_start + l4_header_len, l4_end);
+        l4_header_len = l4_end - l4_start; // options are part of the NDP message
+    }
+    else if (icmp6->icmp6_type == ND_ROUTER_ADVERT) {
+        struct nd_router_advert *ra = (struct nd_router_advert *)l4_start;
+        l4_header_len = sizeof(struct nd_router_advert);
+        show("\t|-Cur Hop Limit   : %d\n", ra->nd_ra_curhoplimit);
+        show("\t|-Flags => |Managed:%d|Other:%d|\n",
+               (ra->nd_ra_flags_reserved & ND_RA_FLAG_MANAGED) ? 1 : 0,
+               (ra->nd_ra_flags_reserved & ND_RA_FLAG_OTHER) ? 1 : 0);
+        show("\t|-Router Lifetime : %ds\n", ntohs(ra->nd_ra_router_lifetime));
+        show("\t|-Reachable Time  : %ums\n", ntohl(ra->nd_ra_reachable));
+        show("\t|-Retrans Timer   : %ums\n", ntohl(ra->nd_ra_retransmit));
+        print_ndp_options(l4_start + l4_header_len, l4_end);
+        l4_header_len = l4_end - l4_start;
+    }
+    else if (icmp6->icmp6_type == ND_NEIGHBOR_SOLICIT) {
+        struct nd_neighbor_solicit *ns = (struct nd_neighbor_solicit *)l4_start;
+        l4_header_len = sizeof(struct nd_neighbor_solicit);
+        show("\t|-Target Address  : %s\n", inet_ntop(AF_INET6, &ns->nd_ns_target, addr6, sizeof(addr6)));
+        print_ndp_options(l4_start + l4_header_len, l4_end);
+        l4_header_len = l4_end - l4_start;
+    }
+    else if (icmp6->icmp6_type == ND_NEIGHBOR_ADVERT) {
+        struct nd_neighbor_advert *na = (struct nd_neighbor_advert *)l4_start;
+        l4_header_len = sizeof(struct nd_neighbor_advert);
+        show("\t|-Flags => |Router:%d|Solicited:%d|Override:%d|\n",
+               (na->nd_na_flags_reserved & ND_NA_FLAG_ROUTER) ? 1 : 0,
+               (na->nd_na_flags_reserved & ND_NA_FLAG_SOLICITED) ? 1 : 0,
+               (na->nd_na_flags_reserved & ND_NA_FLAG_OVERRIDE) ? 1 : 0);
+        show("\t|-Target Address  : %s\n", inet_ntop(AF_INET6, &na->nd_na_target, addr6, sizeof(addr6)));
+        print_ndp_options(l4_start + l4_header_len, l4_end);
+        l4_header_len = l4_end - l4_start;
+    }
+    else if (icmp6->icmp6_type == ND_REDIRECT) {
+        struct nd_redirect *rd = (struct nd_redirect *)l4_start;
+        l4_header_len = sizeof(struct nd_redirect);
+        show("\t|-Target Address  : %s\n", inet_ntop(AF_INET6, &rd->nd_rd_target, addr6, sizeof(addr6)));
+        show("\t|-Dest Address    : %s\n", inet_ntop(AF_INET6, &rd->nd_rd_dst, addr6, sizeof(addr6)));
+        print_ndp_options(l4_start + l4_header_len, l4_end);
+        l4_header_len = l4_end - l4_start;
+    }
+    c->l4_header_len = l4_header_len;
+    return 0;
+}
+
+static int dissect_no_l4(struct dissect_ctx *c) {
+    (void)c;
+    show("[No L4 Header] (non-first fragment or IPv6 No-Next-Header)\n");
+    return 0;
+}
+
+static int dissect_unknown_proto(struct dissect_ctx *c) {
+    (void)c;
+    show("Protocol Not Supported! Valid types = TCP:%d, UDP:%d, ICMP:%d, IGMP:%d, ICMPv6:%d, skipping unpacking further...\n", 
+        IPPROTO_TCP, IPPROTO_UDP, IPPROTO_ICMP, IPPROTO_IGMP, IPPROTO_ICMPV6);
+    return -1;
+}
+
+// Every supported protocol, one line each; new L7 decoders only need a line here
+void register_dissectors(void) {
+    dissector_set_default(DISSECT_ETHERTYPE, "unknown", dissect_unknown_ethertype);
+    dissector_register(DISSECT_ETHERTYPE, ETHERTYPE_ARP, "ARP", dissect_arp);
+    dissector_register(DISSECT_ETHERTYPE, ETHERTYPE_REVARP, "ARP", dissect_arp);
+    dissector_register(DISSECT_ETHERTYPE, ETHERTYPE_IP, "IPv4", dissect_ipv4);
+    dissector_register(DISSECT_ETHERTYPE, ETHERTYPE_IPV6, "IPv6", dissect_ipv6);
+
+    dissector_set_default(DISSECT_IP_PROTO, "unsupported", dissect_unknown_proto);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_TCP, "TCP", dissect_tcp);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_UDP, "UDP", dissect_udp);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_ICMP, "ICMP", dissect_icmp);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_IGMP, "IGMP", dissect_igmp);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_ICMPV6, "ICMPv6", dissect_icmpv6);
+    dissector_register(DISSECT_IP_PROTO, IPPROTO_NONE, "no L4 header", dissect_no_l4);
+
+    dissector_register(DISSECT_UDP_PORT, 53, "DNS", dissect_dns);
+    dissector_init(); // remaining defaults (TCP/UDP ports without a decoder) do nothing
+}
+
+// Decode one frame: prints it (unless print_packets is off) and fills 'meta' as it goes
+void decode_packet(const struct pcap_pkthdr *header, const u_char *packet, struct pkt_meta *meta) {
+    n++;
+    show("\n=== PACKET FRAME %d ===\n", n);
 
     // Layer 2: Ethernet Header
     struct ether_header *eth = (struct ether_header *) packet;
-    printf("[L2 Ethernet]\n");
-    printf("\t|-Source MAC      : %02X:%02X:%02X:%02X:%02X:%02X\n", 
+    show("[L2 Ethernet]\n");
+    show("\t|-Source MAC      : %02X:%02X:%02X:%02X:%02X:%02X\n", 
            eth->ether_shost[0], eth->ether_shost[1], eth->ether_shost[2], 
            eth->ether_shost[3], eth->ether_shost[4], eth->ether_shost[5]);
-    printf("\t|-Destination MAC : %02X:%02X:%02X:%02X:%02X:%02X\n", 
+    show("\t|-Destination MAC : %02X:%02X:%02X:%02X:%02X:%02X\n", 
            eth->ether_dhost[0], eth->ether_dhost[1], eth->ether_dhost[2], 
            eth->ether_dhost[3], eth->ether_dhost[4], eth->ether_dhost[5]);
            
@@ -43,239 +707,153 @@ void process_packet(u_char *args, const struct pcap_pkthdr *header, const u_char
 
         uint16_t tci = ntohs(vlan->tci);
         vlan_count++;
+        if (vlan_count == 1) meta->outer_vid = tci & 0x0FFF;
+        meta->inner_vid = tci & 0x0FFF;
 
-        printf("\t[VLAN Tag #%d] => ", vlan_count);
-        printf("|Protocol(TPID):0x%04X",current_eth_type);
-        printf("|Priority(PCP):%d", (tci >> 13) & 0x07); // first 3 bits = pcp (shift 16-3)
-        printf("|Drop-Eligible(DEI):%d", (tci >> 12) & 0x01); // second 1 bit = dei (shift 16-(3+1))
-        printf("|VID:%d\n", (tci & 0x0FFF)); // last 12 bits mask = vlan number
+        show("\t[VLAN Tag #%d] => ", vlan_count);
+        show("|Protocol(TPID):0x%04X",current_eth_type);
+        show("|Priority(PCP):%d", (tci >> 13) & 0x07); // first 3 bits = pcp (shift 16-3)
+        show("|Drop-Eligible(DEI):%d", (tci >> 12) & 0x01); // second 1 bit = dei (shift 16-(3+1))
+        show("|VID:%d\n", (tci & 0x0FFF)); // last 12 bits mask = vlan number
 
         // Update current EtherType to the one inside this VLAN tag
         current_eth_type = ntohs(vlan->next_type);
         // Advance the offset by 4 bytes (size of a VLAN tag)
         eth_header_len += 4;
     }
-    printf("\t|-EtherType  : 0x%04X\n",current_eth_type);
-
-    // L3^ ARP & RARP Handling
-    if (current_eth_type == ETHERTYPE_ARP || current_eth_type == ETHERTYPE_REVARP) {
-        struct arphdr *arp = (struct arphdr *)(packet + eth_header_len);
-        
-        printf("[%s Header]\n", (current_eth_type == ETHERTYPE_ARP) ? "ARP" : "RARP");
-        printf("\t|-Hardware Type     : %d (Ethernet=1)\n", ntohs(arp->ar_hrd));
-        printf("\t|-Protocol Type     : 0x%04X (IPv4=0800)\n", ntohs(arp->ar_pro));
-        printf("\t|-Hardware Size     : %d\n", arp->ar_hln);
-        printf("\t|-Protocol Size     : %d\n", arp->ar_pln);
-        
-        uint16_t op = ntohs(arp->ar_op);
-        printf("\t|-Opcode            : %d ", op);
-        if(op == ARPOP_REQUEST) printf("(ARP Request)\n");
-        else if(op == ARPOP_REPLY) printf("(ARP Reply)\n");
-        else if(op == ARPOP_RREQUEST) printf("(RARP Request)\n");
-        else if(op == ARPOP_RREPLY) printf("(RARP Reply)\n");
-        else printf("(Unknown)\n");
-
-        // ARP/RARP addresses follow the fixed header
-        unsigned char *sha = (unsigned char *)(arp + 1);            // Sender Hardware Address
-        unsigned char *spa = sha + arp->ar_hln;                     // Sender Protocol Address
-        unsigned char *tha = spa + arp->ar_pln;                     // Target Hardware Address
-        unsigned char *tpa = tha + arp->ar_hln;                     // Target Protocol Address
-
-        printf("\t|-Sender MAC        : %02X:%02X:%02X:%02X:%02X:%02X\n", sha[0],sha[1],sha[2],sha[3],sha[4],sha[5]);
-        printf("\t|-Sender IP         : %d.%d.%d.%d\n", spa[0], spa[1], spa[2], spa[3]);
-        printf("\t|-Target MAC        : %02X:%02X:%02X:%02X:%02X:%02X\n", tha[0],tha[1],tha[2],tha[3],tha[4],tha[5]);
-        printf("\t|-Target IP         : %d.%d.%d.%d\n", tpa[0], tpa[1], tpa[2], tpa[3]);
-        return; // Finished processing ARP/RARP
-    }
-    
-    if (current_eth_type != ETHERTYPE_IP) {
-        printf("Unknown EtherType! Valid types = IPv4:%04X, skipping unpacking further...\n", ETHERTYPE_IP);
-        return;
-    }
-    
-    // Layer 3: IPv4 Header (Adjusted offset for possible VLAN tag)
-    struct ip *ip = (struct ip *)(packet + eth_header_len);
-    uint ip_header_len = ip->ip_hl * header_scale;
-    uint16_t ip_frag_off_field = ntohs(ip->ip_off); 
-    uint ip_fragment_offset = (ip_frag_off_field & IP_OFFMASK) * fragment_scale;
-    printf("[L3 IPv4]\n");
-    printf("\t|-IP Version        : %d\n", (uint)ip->ip_v);
-
-    printf("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n",
-            (uint)ip->ip_hl, header_scale, ip_header_len);
-
-    printf("\t|-Type Of Service   : %d\n", (uint)ip->ip_tos);
-    printf("\t|-Total Length      : %d Bytes\n", ntohs(ip->ip_len));
-    printf("\t|-Identification    : %d\n", ntohs(ip->ip_id));
-
-    printf("\t[Flags] => |Reserved-Bit:%d|Dont-Fragment:%d|More-Fragments:%d|\n", 
-        (ip_frag_off_field& IP_RF) >> 15, (ip_frag_off_field & IP_DF) >> 14, (ip_frag_off_field & IP_MF) >> 13);
-
-    printf("\t|-Fragment Offset  => Offset:%d * ScalingFactor:%d = %d\n",
-            (uint)(ip_frag_off_field & IP_OFFMASK), fragment_scale, ip_fragment_offset);
-
-    printf("\t|-TTL               : %d\n", (uint)ip->ip_ttl);
-    printf("\t|-Protocol          : %d\n", (uint)ip->ip_p);
-    printf("\t|-Header Checksum   : %d\n", ntohs(ip->ip_sum));
-    printf("\t|-Source IP         : %s\n", inet_ntoa(ip->ip_src));
-    printf("\t|-Destination IP    : %s\n", inet_ntoa(ip->ip_dst));
-
-    // Layer 4: Transport Layer || Control Layer (Switch based on ip->ip_p)
-    uint l4_header_len = 0;
-    const u_char *l4_start = packet + eth_header_len + ip_header_len;
-
-    switch (ip->ip_p) {
-        case IPPROTO_TCP: {
-            struct tcphdr *tcp = (struct tcphdr *)l4_start;
-            l4_header_len = tcp->doff * header_scale;
-            printf("[L4 TCP]\n");
-            printf("\t|-Source Port       : %u\n", ntohs(tcp->source));
-            printf("\t|-Destination Port  : %u\n", ntohs(tcp->dest));
-            printf("\t|-Sequence No.      : %u\n", ntohl(tcp->seq));
-            printf("\t|-Acknowledge No.   : %u\n", ntohl(tcp->ack_seq));
-
-            printf("\t|-Header Length => Offset:%d * ScalingFactor:%d = %d Bytes\n",
-                    (uint)tcp->doff, header_scale, l4_header_len);
-
-            printf("\t|-Flags => |URG:%d|ACK:%d|PSH:%d|RST:%d|SYN:%d|FIN:%d|\n", 
-                    (tcp->th_flags & TH_URG) ? 1 : 0, (tcp->th_flags & TH_ACK) ? 1 : 0, (tcp->th_flags & TH_PUSH) ? 1 : 0,
-                    (tcp->th_flags & TH_RST) ? 1 : 0, (tcp->th_flags & TH_SYN) ? 1 : 0, (tcp->th_flags & TH_FIN) ? 1 : 0);
-            
-            printf("\t|-Window Size       : %d\n", ntohs(tcp->window));
-            printf("\t|-Checksum          : %d\n", ntohs(tcp->check));
-            printf("\t|-Urgent Pointer    : %d\n", tcp->urg_ptr);
-            break;
-        }
-
-        case IPPROTO_ICMP: {
-            struct icmphdr *icmp = (struct icmphdr *)l4_start;
-            l4_header_len = 8; // ICMP header is 8 bytes
-            printf("[L4 ICMP]\n");
-            
-            // 1. Basic ICMP Fields
-            printf("\t|-Type     : %d ", icmp->type);
-            
-            // Decoding the Type
-            switch(icmp->type) {
-                case ICMP_ECHOREPLY:     printf("(Echo Reply)\n"); break;
-                case ICMP_DEST_UNREACH:  printf("(Destination Unreachable)\n"); break;
-                case ICMP_REDIRECT:      printf("(Redirect / Routing Error)\n"); break;
-                case ICMP_ECHO:          printf("(Echo Request)\n"); break;
-                case ICMP_TIME_EXCEEDED: printf("(Time Exceeded / TTL Expired)\n"); break;
-                default:                 printf("(Other / Feedback)\n"); break;
-            }
-
-            printf("\t|-Code     : %d\n", (uint)icmp->code);
-            printf("\t|-Checksum : %d\n", ntohs(icmp->checksum));
-
-            // 2. Specialized Format Handling
-            // Echo Request/Reply (Ping)
-            if (icmp->type == ICMP_ECHO || icmp->type == ICMP_ECHOREPLY) {
-                printf("\t|-Identifier : %d\n", ntohs(icmp->un.echo.id));
-                printf("\t|-Sequence   : %d\n", ntohs(icmp->un.echo.sequence));
-            } 
-            // Gateway Redirect
-            else if (icmp->type == ICMP_REDIRECT) {
-                struct in_addr gw;
-                gw.s_addr = icmp->un.gateway;
-                printf("\t|-Gateway Addr: %s\n", inet_ntoa(gw));
-            }
-            // Error handling (Destination Unreachable / Time Exceeded)
-            else if (icmp->type == ICMP_DEST_UNREACH || icmp->type == ICMP_TIME_EXCEEDED) {
-                printf("\t|-Next-Hop MTU: %d (if applicable)\n", ntohs(icmp->un.frag.mtu));
-                printf("\t[Note] This packet contains a copy of the original failed IP header.\n");
-            }
-            break;
-        }
-
-        case IPPROTO_IGMP: {
-            struct igmp *igmp = (struct igmp *)l4_start;
-            l4_header_len = 8;
-            printf("[L4 IGMP]\n");
-            
-            printf("\t|-Type              : 0x%02X ", igmp->igmp_type);
-            switch(igmp->igmp_type) {
-                case IGMP_MEMBERSHIP_QUERY:     printf("(Membership Query)\n"); break;
-                case IGMP_V1_MEMBERSHIP_REPORT: printf("(v1 Membership Report)\n"); break;
-                case IGMP_V2_MEMBERSHIP_REPORT: printf("(v2 Membership Report)\n"); break;
-                case IGMP_V2_LEAVE_GROUP:       printf("(Leave Group)\n"); break;
-                case 0x22:                      printf("(v3 Membership Report)\n"); break;
-                default:                        printf("(Unknown IGMP Type)\n"); break;
-            }
-
-            printf("\t|-Max Response Time : %d\n", igmp->igmp_code);
-            printf("\t|-Checksum          : %d\n", ntohs(igmp->igmp_cksum));
-            printf("\t|-Group Address     : %s\n", inet_ntoa(igmp->igmp_group));
-            break;
-        }
-
-        case IPPROTO_UDP: {
-            struct udphdr *udp = (struct udphdr *)l4_start;
-            l4_header_len = 8; // UDP is always 8 bytes
-            uint16_t src_port = ntohs(udp->source);
-            uint16_t dst_port = ntohs(udp->dest);
-            printf("[L4 UDP]\n");
-            printf("\t|-Source Port       : %u\n", src_port);
-            printf("\t|-Destination Port  : %u\n", dst_port);
-            printf("\t|-UDP Length        : %u\n", ntohs(udp->len));
-            printf("\t|-Checksum          : %d\n", ntohs(udp->check));
-            
-            // --- DNS Handling ---
-            if (src_port == 53 || dst_port == 53) {
-                const u_char *dns_start = l4_start + l4_header_len;
-                printf("[L7 DNS Header]\n");
-                printf("\t|-Transaction ID    : 0x%04X\n", ntohs(*(uint16_t*)(dns_start)));
-                
-                uint16_t flags = ntohs(*(uint16_t*)(dns_start + 2));
-                printf("\t|-Flags             : 0x%04X ", flags);
-                printf("(%s)\n", (flags & 0x8000) ? "Response" : "Query");
-
-                printf("\t|-Questions         : %u\n", ntohs(*(uint16_t*)(dns_start + 4)));
-                printf("\t|-Answer RRs        : %u\n", ntohs(*(uint16_t*)(dns_start + 6)));
-                printf("\t|-Authority RRs     : %u\n", ntohs(*(uint16_t*)(dns_start + 8)));
-                printf("\t|-Additional RRs    : %u\n", ntohs(*(uint16_t*)(dns_start + 10)));
-            }
-            break;
-        }
+    show("\t|-EtherType  : 0x%04X\n",current_eth_type);
+    meta->ethertype = current_eth_type;
+    meta->vlan_count = vlan_count;
+    meta->l3_offset = eth_header_len;
+    STAGE_MARK(STAGE_L2);
+
+    // L3: table lookup on the EtherType (ARP/RARP, IPv4, IPv6 -> L4 -> L7 chain from there)
+    struct dissect_ctx c;
+    c.header = header;
+    c.packet = packet;
+    c.meta = meta;
+    c.eth = eth;
+    c.eth_header_len = eth_header_len;
+    c.eth_type = current_eth_type;
+    dissect(DISSECT_ETHERTYPE, current_eth_type, &c);
+}
 
-        default:
-            printf("Protocol Not Supported! Valid types = TCP:%d, UDP:%d, skipping unpacking further...\n", 
-                IPPROTO_TCP, IPPROTO_UDP);
+// pcap_loop callback
+void process_packet(u_char *args, const struct pcap_pkthdr *header, const u_char *packet) {
+    if (stats_enabled) {
+        cap_stats_packet(&cap_stats, (uint64_t)header->ts.tv_sec * 1000000 + header->ts.tv_usec,
+                         packet, header->caplen, header->len);
+        if (!decode_enabled) {
+            n++;
             return;
+        }
+    }
+    struct pkt_meta meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.ts_us = (uint64_t)header->ts.tv_sec * 1000000 + header->ts.tv_usec;
+    meta.file_index = n;
+    meta.caplen = header->caplen;
+    meta.wirelen = header->len;
+    last_ts_us = meta.ts_us;
+
+    STAGE_PACKET_BEGIN();
+    decode_packet(header, packet, &meta);
+    STAGE_MARK(STAGE_OTHER); // decode work after its last mark (early returns)
+
+    if (col_enabled && col_write_row(&col_out, &meta) < 0) {
+        perror("Column file write failed");
+        col_enabled = 0;
     }
 
-    // L5&6 Final Payload
-    uint total_headers = eth_header_len + ip_header_len + l4_header_len;
-    const u_char *payload = packet + total_headers;
-    uint payload_len = header->caplen - total_headers;
-
-    if (payload_len > 0) {
-        printf("[Payload (%d bytes)]\n  \"", payload_len);
-        for(int i = 0; i < payload_len; i++) {
-            if(payload[i] >= 32 && payload[i] <= 126) printf("%c", payload[i]);
-            else printf("."); // Print non-printable chars as dots
+    // Reduced capture: VLAN selection (outer or inner tag) and BPF filter, then snaplen slicing
+    if (pcap_out_enabled &&
+        (out_vlan < 0 || (meta.vlan_count && (meta.outer_vid == out_vlan || meta.inner_vid == out_vlan))) &&
+        (!out_filter_enabled || pcap_offline_filter(&out_filter, header, packet))) {
+        if (pcapw_write(&pcap_out, &header->ts, packet, header->caplen, header->len) < 0) {
+            perror("Pcap file write failed");
+            pcap_out_enabled = 0;
         }
-        printf("\"\n");
-    } else {
-        printf("[No Payload Found]\n");
     }
+    STAGE_MARK(STAGE_OUTPUT);
+    STAGE_PACKET_END();
 }
 
 int main(int argc, char *argv[])  {
-    if (argc != 2) {
-        printf("Usage: %s <packet_file.pcap>\n", argv[0]);
+    const char *col_path = NULL, *pcap_path = NULL, *filter_expr = NULL;
+    uint32_t snaplen = 0;
+    int opt, direct_io = 0, list_dissectors = 0;
+    while ((opt = getopt(argc, argv, "o:w:s:V:F:DLS")) != -1) {
+        switch (opt) {
+            case 'o': col_path = optarg; break;
+            case 'w': pcap_path = optarg; break;
+            case 's': snaplen = (uint32_t)strtoul(optarg, NULL, 10); break;
+            case 'V': out_vlan = atoi(optarg) & 0x0FFF; break;
+            case 'F': filter_expr = optarg; break;
+            case 'D': direct_io = 1; break;
+            case 'L': list_dissectors = 1; break;
+            case 'S': stats_enabled = 1; break;
+            default: optind = argc + 1; break; // force the usage message
+        }
+    }
+    register_dissectors();
+    if (list_dissectors) {
+        dissector_print();
+        return 0;
+    }
+    if (optind != argc - 1) {
+        printf("Usage: %s [-L] [-S] [-o decoded.col] [-w out.pcap [-s snaplen] [-V vlan] [-F \"bpf filter\"] [-D]] <packet_file.pcap>\n", argv[0]);
         return 1;
     }
     char errbuf[PCAP_ERRBUF_SIZE];
+    flow_table_init(&flows);
+    arp_cache_init(&arp_cache);
+    igmp_snoop_init(&igmp_snoop);
+    dns_tracker_init(&dns);
     
     // 1. Open the offline pcap file
-    pcap_t *handle = pcap_open_offline(argv[1], errbuf); 
+    pcap_t *handle = pcap_open_offline(argv[optind], errbuf); 
     if (!handle) {
         fprintf(stderr, "Error opening pcap file: %s\n", errbuf);
         return 1;
     }
 
+    if (col_path) {
+        if (col_writer_open(&col_out, col_path) < 0) {
+            perror("Error opening column file");
+            pcap_close(handle);
+            return 1;
+        }
+        col_enabled = 1;
+        print_packets = 0; // formatting would dominate, metadata goes to the file instead
+    }
+
+    if (pcap_path) {
+        if (filter_expr) {
+            if (pcap_compile(handle, &out_filter, filter_expr, 1, PCAP_NETMASK_UNKNOWN) < 0) {
+                fprintf(stderr, "Bad filter \"%s\": %s\n", filter_expr, pcap_geterr(handle));
+                pcap_close(handle);
+                return 1;
+            }
+            out_filter_enabled = 1;
+        }
+        if (pcapw_open(&pcap_out, pcap_path, snaplen, pcap_datalink(handle), direct_io) < 0) {
+            perror("Error opening output pcap file");
+            pcap_close(handle);
+            return 1;
+        }
+        pcap_out_enabled = 1;
+        print_packets = 0;
+    }
+
+    if (stats_enabled) {
+        cap_stats_init(&cap_stats);
+        print_packets = 0;
+        decode_enabled = col_path || pcap_path; // the writers still need the full decode
+    }
+
     printf("Starting packet processing...\n");
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
 
     // 2. Change '1' to '0' to process all packets until EOF
     // The callback 'process_packet' will be executed for every frame found
@@ -285,7 +863,34 @@ int main(int argc, char *argv[])  {
         return 1;
     }
 
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
     printf("\nProcessing complete. Total packets handled: %u\n", n);
+    if (col_path) {
+        if (col_writer_close(&col_out) < 0) perror("Error closing column file");
+        else printf("Decoded metadata written to %s (%llu rows)\n", col_path, (unsigned long long)col_out.hdr.n_rows);
+    }
+    if (pcap_path) {
+        if (pcapw_close(&pcap_out) < 0) perror("Error closing output pcap file");
+        else printf("Reduced capture written to %s (%llu of %u packets, %llu bytes%s)\n", pcap_path,
+                    (unsigned long long)pcap_out.packets, n, (unsigned long long)pcap_out.bytes,
+                    pcap_out.direct ? ", O_DIRECT" : "");
+        if (out_filter_enabled) pcap_freecode(&out_filter);
+    }
+    flow_table_print(&flows);
+    flow_table_free(&flows);
+    dns_tracker_report(&dns);
+    csum_report(&csum);
+    arp_cache_report(&arp_cache, last_ts_us);
+    igmp_snoop_report(&igmp_snoop);
+    STAGE_REPORT();
+    if (stats_enabled) {
+        cap_stats_report(&cap_stats, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+        cap_stats_free(&cap_stats);
+    }
+    dns_tracker_free(&dns);
+    arp_cache_free(&arp_cache);
+    igmp_snoop_free(&igmp_snoop);
 
     // 3. Close the handle
     pcap_close(handle);
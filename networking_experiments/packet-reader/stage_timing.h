@@ -0,0 +1,150 @@
+// Per-stage latency instrumentation of the decode pipeline (header only, just #include it)
+// Build with -DSTAGE_TIMING to enable it; otherwise every macro below expands to nothing
+// and no timing code or data is compiled in.
+//
+// STAGE_MARK(id) charges the time since the previous mark to stage 'id', so marks are
+// simply placed at stage boundaries. Time spent in a stage within one packet is summed
+// and becomes one sample when the packet ends (a stage entered twice, e.g. L4 before and
+// after DNS, still counts once). Samples go to HDR-style histograms: power of 2 ranges
+// split into 8 linear sub-buckets, i.e. every value is kept with <= 12.5% error.
+// Time source: rdtsc on x86 (converted to ns with a clock_gettime calibration), else
+// clock_gettime(CLOCK_MONOTONIC).
+#ifndef STAGE_TIMING_H
+#define STAGE_TIMING_H
+
+#ifdef STAGE_TIMING
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STAGE_HAVE_TSC 1
+#endif
+
+enum stage_id { STAGE_L2, STAGE_ARP, STAGE_L3, STAGE_FLOW, STAGE_L4, STAGE_DNS, STAGE_PAYLOAD,
+                STAGE_OTHER, STAGE_OUTPUT, STAGE_PACKET, STAGE_N };
+static const char *stage_names[STAGE_N] = {"L2/VLAN", "ARP", "L3", "Flow table", "L4", "DNS",
+                                           "Payload print", "Other", "Output", "Whole packet"};
+
+#define STAGE_SUB_BITS 3 // 8 sub-buckets per power of 2
+#define STAGE_BUCKETS ((64 - STAGE_SUB_BITS + 1) << STAGE_SUB_BITS)
+
+struct stage_hist {
+    uint64_t count, sum, max;    // ticks
+    uint64_t buckets[STAGE_BUCKETS];
+};
+
+static struct stage_hist stage_hists[STAGE_N];
+static uint64_t stage_acc[STAGE_N];  // current packet's time per stage
+static uint32_t stage_touched;       // bit per stage entered in the current packet
+static uint64_t stage_mark_ticks, stage_packet_ticks;
+static uint64_t stage_calib_ticks;   // tick / ns pair taken at the first packet
+static struct timespec stage_calib_ts;
+
+static inline uint64_t stage_now(void) {
+#ifdef STAGE_HAVE_TSC
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static inline uint32_t stage_bucket(uint64_t v) {
+    if (v < (1u << STAGE_SUB_BITS)) return (uint32_t)v;
+    uint32_t e = 63 - __builtin_clzll(v); // e >= STAGE_SUB_BITS
+    return ((e - STAGE_SUB_BITS + 1) << STAGE_SUB_BITS) | (uint32_t)((v >> (e - STAGE_SUB_BITS)) & ((1u << STAGE_SUB_BITS) - 1));
+}
+
+// Smallest value that falls into bucket 'b'
+static inline uint64_t stage_bucket_low(uint32_t b) {
+    if (b < (1u << STAGE_SUB_BITS)) return b;
+    uint32_t e = (b >> STAGE_SUB_BITS) + STAGE_SUB_BITS - 1;
+    return ((uint64_t)((1u << STAGE_SUB_BITS) | (b & ((1u << STAGE_SUB_BITS) - 1)))) << (e - STAGE_SUB_BITS);
+}
+
+static inline void stage_record(enum stage_id id, uint64_t ticks) {
+    struct stage_hist *h = &stage_hists[id];
+    h->count++;
+    h->sum += ticks;
+    if (ticks > h->max) h->max = ticks;
+    h->buckets[stage_bucket(ticks)]++;
+}
+
+static inline void stage_packet_begin(void) {
+    if (!stage_calib_ticks) {
+        clock_gettime(CLOCK_MONOTONIC, &stage_calib_ts);
+        stage_calib_ticks = stage_now();
+    }
+    stage_touched = 0;
+    stage_packet_ticks = stage_mark_ticks = stage_now();
+}
+
+static inline void stage_mark(enum stage_id id) {
+    uint64_t t = stage_now();
+    stage_acc[id] += t - stage_mark_ticks;
+    stage_touched |= 1u << id;
+    stage_mark_ticks = t;
+}
+
+static inline void stage_packet_end(void) {
+    stage_record(STAGE_PACKET, stage_now() - stage_packet_ticks);
+    for (uint32_t bits = stage_touched; bits; bits &= bits - 1) {
+        int id = __builtin_ctz(bits);
+        stage_record((enum stage_id)id, stage_acc[id]);
+        stage_acc[id] = 0;
+    }
+}
+
+static uint64_t stage_percentile(const struct stage_hist *h, double q) {
+    uint64_t rank = (uint64_t)(q * h->count), seen = 0;
+    for (uint32_t b = 0; b < STAGE_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > rank) return stage_bucket_low(b);
+    }
+    return h->max;
+}
+
+void stage_report(void) {
+    if (!stage_hists[STAGE_PACKET].count) return;
+    double ns_per_tick = 1.0;
+#ifdef STAGE_HAVE_TSC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ticks = stage_now() - stage_calib_ticks;
+    double ns = (ts.tv_sec - stage_calib_ts.tv_sec) * 1e9 + (ts.tv_nsec - stage_calib_ts.tv_nsec);
+    if (ticks) ns_per_tick = ns / ticks;
+#endif
+    printf("\n[Stage Timing] ns per packet (%s, %.3f ns/tick)\n",
+#ifdef STAGE_HAVE_TSC
+           "rdtsc",
+#else
+           "clock_gettime",
+#endif
+           ns_per_tick);
+    printf("\t%-14s %10s %9s %9s %9s %9s %9s %11s\n", "STAGE", "SAMPLES", "MEAN", "P50", "P90", "P99", "P99.9", "MAX");
+    for (int id = 0; id < STAGE_N; id++) {
+        const struct stage_hist *h = &stage_hists[id];
+        if (!h->count) continue;
+        printf("\t%-14s %10llu %9.0f %9.0f %9.0f %9.0f %9.0f %11.0f\n", stage_names[id], (unsigned long long)h->count,
+               (double)h->sum / h->count * ns_per_tick, stage_percentile(h, 0.50) * ns_per_tick,
+               stage_percentile(h, 0.90) * ns_per_tick, stage_percentile(h, 0.99) * ns_per_tick,
+               stage_percentile(h, 0.999) * ns_per_tick, h->max * ns_per_tick);
+    }
+}
+
+#define STAGE_PACKET_BEGIN() stage_packet_begin()
+#define STAGE_MARK(id) stage_mark(id)
+#define STAGE_PACKET_END() stage_packet_end()
+#define STAGE_REPORT() stage_report()
+
+#else // !STAGE_TIMING
+
+#define STAGE_PACKET_BEGIN() do {} while (0)
+#define STAGE_MARK(id) do {} while (0)
+#define STAGE_PACKET_END() do {} while (0)
+#define STAGE_REPORT() do {} while (0)
+
+#endif
+#endif
@@ -1,35 +1,103 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <limits.h>
 #define MAX_SIZE 3
 
-typedef struct Node{
-    char* key;
-    int data;
-    struct Node* next;
-} Node;
+// 64 bit hash, 8 bytes per step (multiply / xor-shift mixing, splitmix64 finalizer)
+uint64_t hashBytes(const char* key, size_t len)
+{
+    uint64_t h = 0x9E3779B97F4A7C15ULL ^ (len * 0xFF51AFD7ED558CCDULL);
+    uint64_t w;
+    for (; len >= 8; key += 8, len -= 8) {
+        memcpy(&w, key, 8);
+        h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 29;
+    }
+    w = 0;
+    memcpy(&w, key, len);
+    h = (h ^ w) * 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 31;
+    h *= 0x94D049BB133111EBULL;
+    return h ^ (h >> 32);
+}
 
+// --- Arena ---
+// Bump allocator: allocations are carved out of big blocks and only freed all together
+#define ARENA_BLOCK_SIZE (64 * 1024)
 
-unsigned int hash(const char* key)
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* head; // current block, older (full) ones behind it
+    size_t bytes;     // handed out so far
+} Arena;
+
+void* arenaAlloc(Arena* arena, size_t size)
 {
-    unsigned int h = 0;
-    while (*key) 
-        h = (h * 5) + *key++; // prev*5 + next_char
-    return h % MAX_SIZE;
+    size = (size + 7) & ~(size_t)7; // keep everything 8 byte aligned
+    ArenaBlock* b = arena->head;
+    if (!b || b->size - b->used < size) {
+        size_t blockSize = size > ARENA_BLOCK_SIZE / 4 ? size : ARENA_BLOCK_SIZE;
+        ArenaBlock* nb = (ArenaBlock*)malloc(sizeof(ArenaBlock) + blockSize);
+        if (!nb) {
+            perror("Failed to grow arena");
+            exit(1);
+        }
+        nb->used = 0;
+        nb->size = blockSize;
+        if (b && blockSize != ARENA_BLOCK_SIZE) { // big one-off: keep bumping the current block
+            nb->next = b->next;
+            b->next = nb;
+        }
+        else {
+            nb->next = b;
+            arena->head = nb;
+        }
+        b = nb;
+    }
+    void* p = b->data + b->used;
+    b->used += size;
+    arena->bytes += size;
+    return p;
 }
 
-Node* insertNode(Node* head, int val)
+void freeArena(Arena* arena)
 {
-    Node* newNode = (Node*)malloc(sizeof(Node));
-    newNode->data = val;
-    newNode->next = head;
-    return newNode;
+    ArenaBlock* b = arena->head;
+    while (b != NULL) {
+        ArenaBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    arena->head = NULL;
+    arena->bytes = 0;
 }
 
-Node* insertNodeKey(Node* head, const char* key, int val)
+// Key copied once into the map's arena, hash computed once and kept with it
+typedef struct {
+    uint32_t hash; // low 32 bits of hashBytes()
+    uint32_t len;
+    char str[];    // NUL terminated
+} InternedKey;
+
+typedef struct Node{
+    const InternedKey* key; // HashMap nodes only
+    int data;
+    struct Node* next;
+} Node;
+
+
+Node* insertNode(Node* head, int val)
 {
     Node* newNode = (Node*)malloc(sizeof(Node));
-    newNode->key = strdup(key);
     newNode->data = val;
     newNode->next = head;
     return newNode;
@@ -107,75 +175,717 @@ int dequeue(Queue* q) {
 }
 
 // string(key-index) -> int (data)
+// Chained buckets, the bucket array doubles when it holds as many keys as buckets.
+// Nodes and keys come from the map's arena: one bump instead of malloc + strdup per put,
+// keys carry their length and hash so chains are walked comparing those, not strings.
+// Rehashing is incremental (like Redis' dict): while growing, the old and the new table
+// coexist and each put/get/remove moves HM_REHASH_STEP buckets of the old one, so the
+// cost of a resize is spread over the following operations instead of stalling one of them.
+#define HM_INITIAL_BUCKETS 4
+#define HM_REHASH_STEP 1
+#define HM_REHASH_EMPTY_VISITS 10 // empty buckets skipped per moved bucket, bounds the step
+
 typedef struct {
-    Node* buckets[MAX_SIZE];
+    Node** buckets;
+    unsigned int mask; // bucket count - 1 (power of 2)
+    unsigned int used; // keys
+} BucketTable;
+
+#define HM_KEY_CLASSES 16 // removed keys up to 16 * 8 bytes are recycled by size class, longer ones by best fit
+
+typedef struct {
+    BucketTable table[2]; // [1] is the table being grown into, only while rehashing
+    long rehashIdx;       // next bucket of table[0] to move, -1 when not rehashing
+    Arena arena;          // every node and key of the map, freed in one go by freeMap()
+    Node* freeNodes;      // removed nodes, reused before bumping the arena
+    InternedKey* freeKeys[HM_KEY_CLASSES]; // removed keys, by 8 byte size class
+    InternedKey* freeLongKeys;             // removed longer keys, smallest block first
 } HashMap;
 
-void putKeyVal(HashMap* map, const char* key, int val)
+int mapVerbose = 1; // print the bucket of every put/get/remove (off for the benchmark)
+unsigned int mapRehashStep = HM_REHASH_STEP; // UINT_MAX: rehash everything at once (benchmark baseline)
+
+static void initBucketTable(BucketTable* t, unsigned int buckets)
+{
+    t->buckets = (Node**)calloc(buckets, sizeof(Node*));
+    if (!t->buckets) {
+        perror("Failed to allocate hash map buckets");
+        exit(1);
+    }
+    t->mask = buckets - 1;
+    t->used = 0;
+}
+
+void initMap(HashMap* map)
+{
+    memset(map, 0, sizeof(*map));
+    initBucketTable(&map->table[0], HM_INITIAL_BUCKETS);
+    map->rehashIdx = -1;
+}
+
+// Bulk free: the bucket arrays and the arena, no walk over the nodes
+void freeMap(HashMap* map)
 {
-    int idx = hash(key);
-    printf("put() hash idx for %s is %d\n", key, idx);
-    Node* curr = map->buckets[idx];
+    free(map->table[0].buckets);
+    free(map->table[1].buckets);
+    freeArena(&map->arena);
+    memset(map, 0, sizeof(*map));
+    map->rehashIdx = -1;
+}
+
+static inline size_t keyClass(size_t len)
+{
+    return (sizeof(InternedKey) + len + 1 + 7) / 8; // 8 byte units, >= 2: room for the free list link
+}
+
+// Arena bytes of a key: long ones are preceded by the size of their block (8 byte units),
+// so a reused block keeps its whole size however short the key now stored in it
+static inline size_t keyBytes(size_t len)
+{
+    size_t c = keyClass(len);
+    return c < HM_KEY_CLASSES ? c * 8 : sizeof(size_t) + c * 8;
+}
+
+static inline size_t* longKeyUnits(const InternedKey* k)
+{
+    return (size_t*)k - 1;
+}
+
+// A removed key's first bytes link it into its free list
+static inline InternedKey* nextFreeKey(const InternedKey* k)
+{
+    InternedKey* next;
+    memcpy(&next, k, sizeof(InternedKey*));
+    return next;
+}
+
+static inline void setNextFreeKey(InternedKey* k, InternedKey* next)
+{
+    memcpy(k, &next, sizeof(InternedKey*));
+}
+
+// Smallest removed long key block of at least c units, unlinked; NULL if none is big enough
+static InternedKey* takeLongKey(HashMap* map, size_t c)
+{
+    InternedKey *prev = NULL, *k = map->freeLongKeys;
+    while (k && *longKeyUnits(k) < c) {
+        prev = k;
+        k = nextFreeKey(k);
+    }
+    if (k) {
+        if (prev)
+            setNextFreeKey(prev, nextFreeKey(k));
+        else
+            map->freeLongKeys = nextFreeKey(k);
+    }
+    return k;
+}
+
+static const InternedKey* newKey(HashMap* map, const char* key, size_t len, uint32_t h)
+{
+    size_t c = keyClass(len);
+    InternedKey* k;
+    if (c < HM_KEY_CLASSES && map->freeKeys[c]) {
+        k = map->freeKeys[c];
+        map->freeKeys[c] = nextFreeKey(k);
+    }
+    else if (c < HM_KEY_CLASSES)
+        k = (InternedKey*)arenaAlloc(&map->arena, c * 8);
+    else if (!(k = takeLongKey(map, c))) {
+        size_t* units = (size_t*)arenaAlloc(&map->arena, keyBytes(len));
+        *units = c;
+        k = (InternedKey*)(units + 1);
+    }
+    k->hash = h;
+    k->len = (uint32_t)len;
+    memcpy(k->str, key, len + 1);
+    return k;
+}
+
+static Node* newNode(HashMap* map, const InternedKey* key, int val, Node* next)
+{
+    Node* node = map->freeNodes;
+    if (node)
+        map->freeNodes = node->next;
+    else
+        node = (Node*)arenaAlloc(&map->arena, sizeof(Node));
+    node->key = key;
+    node->data = val;
+    node->next = next;
+    return node;
+}
+
+// Back to the free lists: the memory itself only goes away with the arena
+static void releaseNode(HashMap* map, Node* node)
+{
+    size_t c = keyClass(node->key->len);
+    InternedKey* k = (InternedKey*)node->key;
+    if (c < HM_KEY_CLASSES) {
+        setNextFreeKey(k, map->freeKeys[c]);
+        map->freeKeys[c] = k;
+    }
+    else { // sorted insert, linear: long keys are expected to be the exception
+        InternedKey *prev = NULL, *next = map->freeLongKeys;
+        while (next && *longKeyUnits(next) < *longKeyUnits(k)) {
+            prev = next;
+            next = nextFreeKey(next);
+        }
+        setNextFreeKey(k, next);
+        if (prev)
+            setNextFreeKey(prev, k);
+        else
+            map->freeLongKeys = k;
+    }
+    node->next = map->freeNodes;
+    map->freeNodes = node;
+}
+
+// Move up to 'steps' non-empty buckets of table[0] into table[1]
+static void rehashStep(HashMap* map, unsigned int steps)
+{
+    BucketTable* from = &map->table[0];
+    BucketTable* to = &map->table[1];
+    unsigned long emptyVisits = (unsigned long)steps * HM_REHASH_EMPTY_VISITS;
+    while (steps-- && from->used != 0) {
+        while (from->buckets[map->rehashIdx] == NULL) { // used != 0: a full bucket lies ahead
+            map->rehashIdx++;
+            if (--emptyVisits == 0)
+                return;
+        }
+        Node* curr = from->buckets[map->rehashIdx];
+        while (curr != NULL) {
+            Node* next = curr->next;
+            unsigned int idx = curr->key->hash & to->mask; // no rehashing of the string
+            curr->next = to->buckets[idx];
+            to->buckets[idx] = curr;
+            from->used--;
+            to->used++;
+            curr = next;
+        }
+        from->buckets[map->rehashIdx++] = NULL;
+    }
+    if (from->used == 0) { // done: the new table takes over
+        free(from->buckets);
+        *from = *to;
+        memset(to, 0, sizeof(*to));
+        map->rehashIdx = -1;
+    }
+}
+
+// Same string if it is the same pointer, else hash and length have to match before the bytes are compared
+static inline int keyEquals(const InternedKey* k, const char* key, size_t len, uint32_t h)
+{
+    return k->str == key || (k->hash == h && k->len == len && memcmp(k->str, key, len) == 0);
+}
+
+static Node* findNode(BucketTable* t, const char* key, size_t len, uint32_t h)
+{
+    Node* curr = t->buckets[h & t->mask];
     while(curr!=NULL)
     {
-        if(strcmp(curr->key, key) == 0)
-        {
-            curr->data = val;
-            return;
-        }
+        if(keyEquals(curr->key, key, len, h))
+            return curr;
         curr = curr->next;
     }
-    map->buckets[idx] = insertNodeKey(map->buckets[idx], key, val);
+    return NULL;
 }
 
-void removeKey(HashMap* map, const char* key)
+void putKeyVal(HashMap* map, const char* key, int val)
 {
-    int idx = hash(key);
-    printf("remove() hash idx for %s is %d\n", key, idx);
-    Node* prev = map->buckets[idx];
-    Node* curr = prev->next;
-    if(prev!=NULL && strcmp(prev->key, key) == 0)
-    {
-        map->buckets[idx] = prev->next;
-        free(prev);
+    size_t len = strlen(key);
+    uint32_t h = (uint32_t)hashBytes(key, len);
+    if (map->rehashIdx >= 0)
+        rehashStep(map, mapRehashStep);
+    Node* found = findNode(&map->table[0], key, len, h);
+    if (!found && map->rehashIdx >= 0)
+        found = findNode(&map->table[1], key, len, h);
+    if (found) {
+        found->data = val;
         return;
     }
-    
-    while(curr!=NULL)
-    {
-        if(strcmp(curr->key, key) == 0)
+    if (map->rehashIdx < 0 && map->table[0].used >= map->table[0].mask + 1) { // start growing
+        initBucketTable(&map->table[1], 2 * (map->table[0].mask + 1));
+        map->rehashIdx = 0;
+    }
+    BucketTable* t = &map->table[map->rehashIdx >= 0]; // new keys go straight to the new table
+    int idx = h & t->mask;
+    if (mapVerbose) printf("put() hash idx for %s is %d\n", key, idx);
+    t->buckets[idx] = newNode(map, newKey(map, key, len, h), val, t->buckets[idx]);
+    t->used++;
+}
+
+void removeKey(HashMap* map, const char* key)
+{
+    size_t len = strlen(key);
+    uint32_t h = (uint32_t)hashBytes(key, len);
+    if (map->rehashIdx >= 0)
+        rehashStep(map, mapRehashStep);
+    for (int t = 0; t <= (map->rehashIdx >= 0); t++) {
+        BucketTable* table = &map->table[t];
+        int idx = h & table->mask;
+        if (mapVerbose) printf("remove() hash idx for %s is %d\n", key, idx);
+        for (Node** link = &table->buckets[idx]; *link != NULL; link = &(*link)->next)
         {
-            prev->next = curr->next;
-            free(curr);
-            return;
+            if(keyEquals((*link)->key, key, len, h))
+            {
+                Node* found = *link;
+                *link = found->next;
+                releaseNode(map, found); // node and key both
+                table->used--;
+                return;
+            }
         }
-        prev = curr;
-        curr = curr->next;
     }
 }
 
 int get(HashMap* map, const char* key) 
 {
-    int idx = hash(key);
-    printf("get() hash idx for %s is %d\n", key, idx);
-    Node* curr = map->buckets[idx];
-    while(curr!=NULL)
-    {
-        if(strcmp(curr->key, key) == 0)
-        {
-            return curr->data;
+    size_t len = strlen(key);
+    uint32_t h = (uint32_t)hashBytes(key, len);
+    if (map->rehashIdx >= 0)
+        rehashStep(map, mapRehashStep);
+    for (int t = 0; t <= (map->rehashIdx >= 0); t++) {
+        if (mapVerbose) printf("get() hash idx for %s is %d\n", key, h & map->table[t].mask);
+        Node* found = findNode(&map->table[t], key, len, h);
+        if (found)
+            return found->data;
+    }
+    return -1;
+}
+
+// --- Open addressing hash map (Robin Hood) ---
+// Same string -> int map as HashMap, but the entries live in one flat slot array: no malloc
+// per insert, no pointer chasing, and the table doubles at 7/8 load. Collisions probe
+// linearly; an insert takes the slot of any entry that is closer to its home slot than the
+// new key is to its own (Robin Hood), so probe lengths stay short and even, and a lookup can
+// stop as soon as it meets an entry richer than the key would be at that position.
+// Keys up to OA_INLINE_KEY bytes are stored inside the slot, longer ones are malloc'd.
+// Growing is incremental: the old table stays next to the new one and every operation
+// moves OA_MIGRATE_STEP of its slots, so no single put pays for rehashing the whole map.
+#define OA_INLINE_KEY 16
+#define OA_MIGRATE_STEP 8
+#define OA_MIN_CAPACITY 8
+
+typedef struct {
+    union {
+        char inl[OA_INLINE_KEY]; // len <= OA_INLINE_KEY
+        char* ptr;               // longer keys
+    } key;
+    uint32_t hash;
+    uint32_t len;
+    int data;
+    uint16_t dist;    // probe distance + 1, 0 = empty slot
+    uint8_t deleted;  // only in the old table of a resize: gone, but still part of probe chains
+} OASlot;             // 32 bytes, two per cache line
+
+typedef struct {
+    OASlot* slots;
+    uint32_t mask;       // capacity - 1 (power of 2)
+    uint32_t count;      // keys in both tables
+    OASlot* old;         // table being migrated from, NULL if not resizing
+    uint32_t oldMask;
+    uint32_t migrateIdx; // old slots below this were moved
+} OAHashMap;
+
+static inline const char* oaKey(const OASlot* s)
+{
+    return s->len <= OA_INLINE_KEY ? s->key.inl : s->key.ptr;
+}
+
+static OASlot* oaFind(OASlot* slots, uint32_t mask, uint32_t h, const char* key, uint32_t len)
+{
+    uint32_t i = h & mask;
+    for (uint16_t dist = 1; ; dist++, i = (i + 1) & mask) {
+        OASlot* s = &slots[i];
+        if (s->dist < dist) // empty, or a richer entry: the key would have displaced it
+            return NULL;
+        if (s->hash == h && s->len == len && !s->deleted && memcmp(oaKey(s), key, len) == 0)
+            return s;
+    }
+}
+
+static void oaInsertSlot(OASlot* slots, uint32_t mask, OASlot in)
+{
+    uint32_t i = in.hash & mask;
+    in.dist = 1;
+    in.deleted = 0;
+    for (; ; in.dist++, i = (i + 1) & mask) {
+        if (slots[i].dist == 0) {
+            slots[i] = in;
+            return;
         }
-        curr = curr->next;
+        if (slots[i].dist < in.dist) { // take the slot, carry on placing the displaced entry
+            OASlot tmp = slots[i];
+            slots[i] = in;
+            in = tmp;
+        }
+    }
+}
+
+// Backward shift delete: pull the following entries one slot closer to home, no tombstones
+static void oaEraseSlot(OASlot* slots, uint32_t mask, uint32_t i)
+{
+    for (; ; i = (i + 1) & mask) {
+        uint32_t next = (i + 1) & mask;
+        if (slots[next].dist <= 1) {
+            slots[i].dist = 0;
+            return;
+        }
+        slots[i] = slots[next];
+        slots[i].dist--;
+    }
+}
+
+static void oaMigrate(OAHashMap* map, uint32_t steps)
+{
+    while (map->old && steps--) {
+        OASlot* s = &map->old[map->migrateIdx];
+        if (s->dist && !s->deleted) {
+            oaInsertSlot(map->slots, map->mask, *s); // heap keys move with their pointer
+            s->deleted = 1;
+        }
+        if (++map->migrateIdx > map->oldMask) {
+            free(map->old);
+            map->old = NULL;
+        }
+    }
+}
+
+static void oaGrow(OAHashMap* map)
+{
+    oaMigrate(map, UINT32_MAX); // a previous resize still running: finish it first
+    OASlot* bigger = (OASlot*)calloc(2 * (size_t)(map->mask + 1), sizeof(OASlot));
+    if (!bigger) {
+        perror("Failed to grow hash map");
+        exit(1);
+    }
+    map->old = map->slots;
+    map->oldMask = map->mask;
+    map->migrateIdx = 0;
+    map->slots = bigger;
+    map->mask = 2 * map->mask + 1;
+}
+
+void initOAMap(OAHashMap* map, uint32_t capacity)
+{
+    uint32_t cap = OA_MIN_CAPACITY;
+    while (cap < capacity)
+        cap *= 2;
+    memset(map, 0, sizeof(*map));
+    map->slots = (OASlot*)calloc(cap, sizeof(OASlot));
+    if (!map->slots) {
+        perror("Failed to allocate hash map");
+        exit(1);
+    }
+    map->mask = cap - 1;
+}
+
+void freeOAMap(OAHashMap* map)
+{
+    for (uint32_t i = 0; i <= map->mask; i++)
+        if (map->slots[i].dist && map->slots[i].len > OA_INLINE_KEY)
+            free(map->slots[i].key.ptr);
+    if (map->old) {
+        for (uint32_t i = 0; i <= map->oldMask; i++)
+            if (map->old[i].dist && !map->old[i].deleted && map->old[i].len > OA_INLINE_KEY)
+                free(map->old[i].key.ptr);
+        free(map->old);
+    }
+    free(map->slots);
+    memset(map, 0, sizeof(*map));
+}
+
+void oaPutKeyVal(OAHashMap* map, const char* key, int val)
+{
+    uint32_t len = strlen(key), h = (uint32_t)hashBytes(key, len);
+    oaMigrate(map, OA_MIGRATE_STEP);
+    OASlot* s = oaFind(map->slots, map->mask, h, key, len);
+    if (!s && map->old)
+        s = oaFind(map->old, map->oldMask, h, key, len); // not moved yet, updated in place
+    if (s) {
+        s->data = val;
+        return;
     }
+    if ((uint64_t)(map->count + 1) * 8 > (uint64_t)(map->mask + 1) * 7)
+        oaGrow(map);
+
+    OASlot in;
+    memset(&in, 0, sizeof(in));
+    in.hash = h;
+    in.len = len;
+    in.data = val;
+    if (len <= OA_INLINE_KEY)
+        memcpy(in.key.inl, key, len);
+    else if (!(in.key.ptr = strdup(key))) {
+        perror("Failed to copy hash map key");
+        exit(1);
+    }
+    oaInsertSlot(map->slots, map->mask, in);
+    map->count++;
+}
+
+int oaGet(OAHashMap* map, const char* key)
+{
+    uint32_t len = strlen(key), h = (uint32_t)hashBytes(key, len);
+    oaMigrate(map, OA_MIGRATE_STEP);
+    OASlot* s = oaFind(map->slots, map->mask, h, key, len);
+    if (!s && map->old)
+        s = oaFind(map->old, map->oldMask, h, key, len);
+    return s ? s->data : -1;
+}
+
+void oaRemoveKey(OAHashMap* map, const char* key)
+{
+    uint32_t len = strlen(key), h = (uint32_t)hashBytes(key, len);
+    oaMigrate(map, OA_MIGRATE_STEP);
+    OASlot* s = oaFind(map->slots, map->mask, h, key, len);
+    if (s) {
+        if (s->len > OA_INLINE_KEY)
+            free(s->key.ptr);
+        oaEraseSlot(map->slots, map->mask, (uint32_t)(s - map->slots));
+        map->count--;
+        return;
+    }
+    if (map->old && (s = oaFind(map->old, map->oldMask, h, key, len))) {
+        if (s->len > OA_INLINE_KEY)
+            free(s->key.ptr);
+        s->deleted = 1; // keep its probe chain intact until the whole old table is gone
+        map->count--;
+    }
+}
+
+// --- Benchmark: HashMap vs OAHashMap ---
+static uint64_t nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static volatile int benchSink;
+
+// Both maps behind one interface, so every map runs the exact same benchmark
+typedef struct {
+    const char* name;
+    void* map;
+    void (*put)(void* map, const char* key, int val);
+    int (*get)(void* map, const char* key);
+    void (*remove)(void* map, const char* key);
+} BenchMap;
+
+static void benchChainedPut(void* map, const char* key, int val) { putKeyVal((HashMap*)map, key, val); }
+static int benchChainedGet(void* map, const char* key) { return get((HashMap*)map, key); }
+static void benchChainedRemove(void* map, const char* key) { removeKey((HashMap*)map, key); }
+static void benchOAPut(void* map, const char* key, int val) { oaPutKeyVal((OAHashMap*)map, key, val); }
+static int benchOAGet(void* map, const char* key) { return oaGet((OAHashMap*)map, key); }
+static void benchOARemove(void* map, const char* key) { oaRemoveKey((OAHashMap*)map, key); }
+
+static int compareU32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// ns per operation, plus the spread of single puts (where resizes show up)
+static void benchmarkMap(BenchMap* m, char (*keys)[32], char (*missing)[32], uint32_t* putNs, int n)
+{
+    uint64_t t0 = nowNs();
+    for (int i = 0; i < n; i++) {
+        uint64_t start = nowNs();
+        m->put(m->map, keys[i], i);
+        putNs[i] = (uint32_t)(nowNs() - start);
+    }
+    uint64_t t1 = nowNs();
+    for (int i = 0; i < n; i++) benchSink += m->get(m->map, keys[i]);
+    uint64_t t2 = nowNs();
+    for (int i = 0; i < n; i++) benchSink += m->get(m->map, missing[i]);
+    uint64_t t3 = nowNs();
+    for (int i = 0; i < n; i++) m->remove(m->map, keys[i]);
+    uint64_t t4 = nowNs();
+
+    qsort(putNs, n, sizeof(*putNs), compareU32);
+    printf("\t%-22s %9.1f %9.1f %9.1f %9.1f %9u %9u %9u\n", m->name, (double)(t1 - t0) / n, (double)(t2 - t1) / n,
+           (double)(t3 - t2) / n, (double)(t4 - t3) / n, putNs[n / 2], putNs[(int)(n * 0.99)],
+           putNs[n - 1]);
+}
+
+void benchmarkMaps(int n)
+{
+    char (*keys)[32] = malloc((size_t)n * sizeof(*keys));
+    char (*missing)[32] = malloc((size_t)n * sizeof(*missing));
+    uint32_t* putNs = malloc((size_t)n * sizeof(*putNs));
+    if (!keys || !missing || !putNs) {
+        perror("Failed to allocate benchmark keys");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        if (i % 4 == 3) // every 4th key too long to be stored inline
+            snprintf(keys[i], sizeof(keys[i]), "session:%08d:token", i);
+        else
+            snprintf(keys[i], sizeof(keys[i]), "user%d", i);
+        snprintf(missing[i], sizeof(missing[i]), "nobody%d", i);
+    }
+    mapVerbose = 0;
+    printf("[Benchmark] %d keys, ns per operation\n", n);
+    printf("\t%-22s %9s %9s %9s %9s %9s %9s %9s\n", "MAP", "PUT", "GET HIT", "GET MISS", "REMOVE", "PUT P50",
+           "PUT P99", "PUT MAX");
+
+    HashMap h;
+    OAHashMap oa;
+    BenchMap chained = {"chained", &h, benchChainedPut, benchChainedGet, benchChainedRemove};
+    BenchMap robinHood = {"robin hood", &oa, benchOAPut, benchOAGet, benchOARemove};
+
+    mapRehashStep = UINT_MAX; // the whole table at once
+    chained.name = "chained, full rehash";
+    initMap(&h);
+    benchmarkMap(&chained, keys, missing, putNs, n);
+    freeMap(&h);
+
+    mapRehashStep = HM_REHASH_STEP;
+    chained.name = "chained, incremental";
+    initMap(&h);
+    benchmarkMap(&chained, keys, missing, putNs, n);
+    freeMap(&h);
+
+    initOAMap(&oa, 0);
+    benchmarkMap(&robinHood, keys, missing, putNs, n);
+    freeOAMap(&oa);
+
+    mapVerbose = 1;
+    free(keys);
+    free(missing);
+    free(putNs);
+}
+
+// --- Verify: random put/get/remove churn against a plain array ---
+// Runs HashMap (incremental and full rehash) and OAHashMap through the same operations and
+// checks every get and the key count against the reference, with periodic "remove all"
+// phases, so growth, migration and the recycling of nodes / keys are all exercised; churn
+// must not grow a HashMap's arena past one node and key per distinct key.
+// Keys are short (inline in OAHashMap), medium (arena size classes) and long (> 128 bytes).
+#define VERIFY_KEYS 5000
+
+static void verifyKey(char* buf, size_t size, int k)
+{
+    if (k % 7 == 0)
+        snprintf(buf, size, "%0150d", k); // beyond HM_KEY_CLASSES and OA_INLINE_KEY
+    else if (k % 3 == 0)
+        snprintf(buf, size, "a-much-longer-key-number-%d", k);
+    else
+        snprintf(buf, size, "k%d", k);
+}
+
+static int verifyMap(BenchMap* m, unsigned int (*count)(void* map), int ops)
+{
+    static int ref[VERIFY_KEYS];
+    char key[160];
+    unsigned int live = 0;
+    uint64_t rng = 88172645463325252ULL;
+    for (int k = 0; k < VERIFY_KEYS; k++)
+        ref[k] = -1;
+    for (int i = 0; i < ops; i++) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17; // xorshift64
+        int k = (int)(rng % VERIFY_KEYS), op = (int)((rng >> 32) % 10);
+        verifyKey(key, sizeof(key), k);
+        if (op < 5) {
+            if (ref[k] < 0) live++;
+            ref[k] = i;
+            m->put(m->map, key, i);
+        }
+        else if (op < 8) {
+            int got = m->get(m->map, key);
+            if (got != ref[k]) {
+                printf("[Verify] %s: get(%s) = %d, expected %d (op %d)\n", m->name, key, got, ref[k], i);
+                return -1;
+            }
+        }
+        else {
+            if (ref[k] >= 0) live--;
+            ref[k] = -1;
+            m->remove(m->map, key);
+        }
+        if (i % (ops / 5 + 1) == ops / 5) { // empty the map: every node / key goes to the free lists
+            for (int j = 0; j < VERIFY_KEYS; j++) {
+                verifyKey(key, sizeof(key), j);
+                m->remove(m->map, key);
+                ref[j] = -1;
+            }
+            live = 0;
+        }
+        if (count(m->map) != live) {
+            printf("[Verify] %s: %u keys, expected %u (op %d)\n", m->name, count(m->map), live, i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Recycling bound: the arena never needs more than one node and key block per distinct key
+static int verifyArena(const HashMap* h, const char* name)
+{
+    char key[160];
+    size_t bound = 0;
+    for (int k = 0; k < VERIFY_KEYS; k++) {
+        verifyKey(key, sizeof(key), k);
+        bound += ((sizeof(Node) + 7) & ~(size_t)7) + keyBytes(strlen(key));
+    }
+    if (h->arena.bytes <= bound)
+        return 0;
+    printf("[Verify] %s: arena grew to %zu bytes, %zu are enough for every key\n", name, h->arena.bytes, bound);
     return -1;
 }
 
+static unsigned int chainedCount(void* map) { return ((HashMap*)map)->table[0].used + ((HashMap*)map)->table[1].used; }
+static unsigned int oaCount(void* map) { return ((OAHashMap*)map)->count; }
 
-void main()
+// Returns 0 if every map agreed with the reference
+int verifyMaps(int ops)
 {
     HashMap h;
-    for(int i=0; i<MAX_SIZE; i++)
-        h.buckets[i] = NULL;
+    OAHashMap oa;
+    BenchMap chained = {"chained, incremental", &h, benchChainedPut, benchChainedGet, benchChainedRemove};
+    BenchMap robinHood = {"robin hood", &oa, benchOAPut, benchOAGet, benchOARemove};
+    int failed = 0;
+    mapVerbose = 0;
+
+    initMap(&h);
+    failed |= verifyMap(&chained, chainedCount, ops);
+    failed |= verifyArena(&h, chained.name);
+    freeMap(&h);
+
+    mapRehashStep = UINT_MAX;
+    chained.name = "chained, full rehash";
+    initMap(&h);
+    failed |= verifyMap(&chained, chainedCount, ops);
+    failed |= verifyArena(&h, chained.name);
+    freeMap(&h);
+    mapRehashStep = HM_REHASH_STEP;
+
+    initOAMap(&oa, 0);
+    failed |= verifyMap(&robinHood, oaCount, ops);
+    freeOAMap(&oa);
+
+    mapVerbose = 1;
+    printf("[Verify] %d operations per map: %s\n", ops, failed ? "FAILED" : "ok");
+    return failed ? 1 : 0;
+}
+
+// gcc -O2 data_structures.c -o data_structures
+// ./data_structures            demo
+// ./data_structures bench [n]  benchmark both maps with n keys (default 1000000)
+// ./data_structures verify [n] check both maps against a reference over n random operations
+//                              (default 2000000, exit status 1 on a mismatch; worth running under -fsanitize=address)
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        benchmarkMaps(argc > 2 ? atoi(argv[2]) : 1000000);
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "verify") == 0)
+        return verifyMaps(argc > 2 ? atoi(argv[2]) : 2000000);
+
+    HashMap h;
+    initMap(&h);
     
     putKeyVal(&h, "apple", 10);
     putKeyVal(&h, "banana", 20);
@@ -188,6 +898,18 @@ void main()
 
     printf("mango: %d\n", get(&h, "mango")); // 30
     printf("grape: %d\n", get(&h, "grape")); // not found
+    freeMap(&h);
+
+    OAHashMap oa;
+    initOAMap(&oa, 0);
+    oaPutKeyVal(&oa, "apple", 10);
+    oaPutKeyVal(&oa, "banana", 20);
+    oaPutKeyVal(&oa, "a very long key, stored outside the slot", 30);
+    oaRemoveKey(&oa, "banana");
+    printf("[OAHashMap] apple: %d, banana: %d, long key: %d, count: %u, capacity: %u\n", oaGet(&oa, "apple"),
+           oaGet(&oa, "banana"), oaGet(&oa, "a very long key, stored outside the slot"), oa.count, oa.mask + 1);
+    freeOAMap(&oa);
+    return 0;
 }
 
     // int arr[5] = {1,2,3,4,5};
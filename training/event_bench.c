@@ -0,0 +1,203 @@
+// gcc -O2 event_bench.c -pthread -o event_bench
+// Throughput / latency sweep of event_manager.h, one CSV row per configuration on stdout
+// (progress on stderr), so runs can be diffed against each other for regressions:
+// ./event_bench [ms per point] [max publishers] > results.csv
+//   sweeps events x subscribers per event x handler cost x publisher threads x sync / async.
+//   Latency is trigger -> last subscriber's handler done (queueing included for async),
+//   kept in log-linear histograms (8 sub-buckets per power of 2, <= 12.5% error).
+#include "event_manager.h"
+
+#define SUB_BITS 3
+#define LAT_BUCKETS ((64 - SUB_BITS + 1) << SUB_BITS)
+#define MAX_THREADS 64 // publishers + workers recording latencies per point
+
+typedef struct {
+    uint64_t publishedNs;
+    uint64_t seq;
+} BenchContext;
+
+typedef struct {
+    uint64_t count, max;
+    uint64_t buckets[LAT_BUCKETS];
+} LatencyHist;
+
+static LatencyHist hists[MAX_THREADS]; // one per recording thread, merged after each point
+static _Atomic int histsUsed;
+static _Atomic int histGeneration;     // bumped per point, threads re-claim a histogram
+static _Thread_local LatencyHist* myHist;
+static _Thread_local int myGeneration = -1;
+static unsigned int handlerCostNs;
+static _Thread_local volatile uint64_t sink; // per thread: a shared one would bounce between cores
+
+static inline uint32_t lat_bucket(uint64_t v) {
+    if (v < (1u << SUB_BITS)) return (uint32_t)v;
+    uint32_t e = 63 - __builtin_clzll(v);
+    return ((e - SUB_BITS + 1) << SUB_BITS) | (uint32_t)((v >> (e - SUB_BITS)) & ((1u << SUB_BITS) - 1));
+}
+
+// Smallest value that falls into bucket 'b'
+static inline uint64_t lat_bucket_low(uint32_t b) {
+    if (b < (1u << SUB_BITS)) return b;
+    uint32_t e = (b >> SUB_BITS) + SUB_BITS - 1;
+    return ((uint64_t)((1u << SUB_BITS) | (b & ((1u << SUB_BITS) - 1)))) << (e - SUB_BITS);
+}
+
+static void record_latency(uint64_t ns) {
+    int gen = atomic_load_explicit(&histGeneration, memory_order_relaxed);
+    if (myGeneration != gen) {
+        int i = atomic_fetch_add(&histsUsed, 1);
+        if (i >= MAX_THREADS) {
+            fprintf(stderr, "event_bench: more than %d recording threads\n", MAX_THREADS);
+            exit(1);
+        }
+        myHist = &hists[i];
+        myGeneration = gen;
+    }
+    myHist->count++;
+    if (ns > myHist->max) myHist->max = ns;
+    myHist->buckets[lat_bucket(ns)]++;
+}
+
+static inline void burn(void) { // the handler's "work"
+    if (handlerCostNs == 0) return;
+    uint64_t end = monotonic_ns() + handlerCostNs;
+    while (monotonic_ns() < end) sink++;
+}
+
+void bench_handler(int eventId, const char* eventName, void* ctx) {
+    (void)eventId; (void)eventName;
+    sink += ((BenchContext*)ctx)->seq;
+    burn();
+}
+
+// registered last, so it runs after every other subscriber of the event
+void bench_last_handler(int eventId, const char* eventName, void* ctx) {
+    bench_handler(eventId, eventName, ctx);
+    record_latency(monotonic_ns() - ((BenchContext*)ctx)->publishedNs);
+}
+
+typedef struct {
+    EventManager* em;
+    int numEvents, async;
+    uint64_t deadlineNs;
+    uint64_t published;
+    uint64_t rng;
+} Publisher;
+
+static void* publisher(void* arg) {
+    Publisher* p = (Publisher*)arg;
+    uint64_t n = 0;
+    do {
+        for (int k = 0; k < 64; k++, n++) { // check the clock every 64 triggers
+            p->rng ^= p->rng >> 12; p->rng ^= p->rng << 25; p->rng ^= p->rng >> 27; // xorshift64
+            int eventId = (int)((p->rng * 0x2545F4914F6CDD1DULL >> 32) % p->numEvents);
+            if (p->async) { // the context has to outlive the call: pooled, the queue holds a reference
+                BenchContext* ctx = (BenchContext*)alloc_event_context(p->em, eventId);
+                ctx->seq = n;
+                ctx->publishedNs = monotonic_ns();
+                trigger_event_by_id(p->em, eventId, ctx);
+                release_event_context(ctx);
+            }
+            else {
+                BenchContext ctx = {monotonic_ns(), n};
+                trigger_event_by_id(p->em, eventId, &ctx);
+            }
+        }
+    } while (monotonic_ns() < p->deadlineNs);
+    p->published = n;
+    return NULL;
+}
+
+static uint64_t percentile(const LatencyHist* h, double q) {
+    uint64_t rank = (uint64_t)(q * h->count), seen = 0;
+    for (uint32_t b = 0; b < LAT_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen > rank) return lat_bucket_low(b);
+    }
+    return h->max;
+}
+
+static void run_point(int async, int numEvents, int numSubs, unsigned int costNs, int numPublishers, unsigned int ms) {
+    EventManager* em = create_manager(numEvents);
+    set_event_logging(em, 0);
+    Module* mods = (Module*)calloc(numSubs, sizeof(Module));
+    for (int s = 0; s < numSubs; s++) {
+        snprintf(mods[s].name, sizeof(mods[s].name), "bench%d", s);
+        mods[s].handleEvent = (s == numSubs - 1) ? bench_last_handler : bench_handler;
+    }
+    for (int e = 0; e < numEvents; e++) {
+        char name[50];
+        snprintf(name, sizeof(name), "bench.e%d", e);
+        set_event_name(em, e, name);
+        reserve_subscribers(em, e, numSubs);
+        for (int s = 0; s < numSubs; s++) register_module_by_id(em, e, &mods[s]);
+        if (async) set_event_context_pool(em, e, sizeof(BenchContext), 256);
+    }
+    handlerCostNs = costNs;
+    memset(hists, 0, sizeof(hists));
+    atomic_store(&histsUsed, 0);
+    atomic_fetch_add(&histGeneration, 1);
+    if (async) {
+        AsyncConfig cfg = {4, 1024, BACKPRESSURE_BLOCK, 0, {0, 0, 0}};
+        start_async_dispatch(em, &cfg);
+    }
+
+    Publisher pubs[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    uint64_t start = monotonic_ns();
+    for (int i = 0; i < numPublishers; i++) {
+        pubs[i] = (Publisher){em, numEvents, async, start + ms * 1000000ULL, 0, 0x9E3779B97F4A7C15ULL * (i + 1)};
+        pthread_create(&threads[i], NULL, publisher, &pubs[i]);
+    }
+    uint64_t published = 0;
+    for (int i = 0; i < numPublishers; i++) {
+        pthread_join(threads[i], NULL);
+        published += pubs[i].published;
+    }
+    if (async) stop_async_dispatch(em); // drain: every published event counts once handled
+    double secs = (monotonic_ns() - start) / 1e9;
+
+    LatencyHist all = {0};
+    int used = atomic_load(&histsUsed);
+    for (int t = 0; t < used && t < MAX_THREADS; t++) {
+        all.count += hists[t].count;
+        if (hists[t].max > all.max) all.max = hists[t].max;
+        for (int b = 0; b < LAT_BUCKETS; b++) all.buckets[b] += hists[t].buckets[b];
+    }
+    printf("%s,%d,%d,%u,%d,%llu,%.3f,%.0f,%llu,%llu,%llu,%llu\n", async ? "async" : "sync", numEvents, numSubs, costNs,
+           numPublishers, (unsigned long long)published, secs, published / secs,
+           (unsigned long long)percentile(&all, 0.50), (unsigned long long)percentile(&all, 0.99),
+           (unsigned long long)percentile(&all, 0.999), (unsigned long long)all.max);
+    fflush(stdout);
+
+    destroy_manager(em);
+    free(mods);
+}
+
+int main(int argc, char* argv[]) {
+    unsigned int ms = (argc > 1) ? strtoul(argv[1], NULL, 10) : 200;
+    int maxPublishers = (argc > 2) ? atoi(argv[2]) : 4;
+    if (ms == 0 || maxPublishers < 1 || maxPublishers > MAX_THREADS - 4)
+        return printf("Usage: %s [ms per point] [max publishers(1-%d)]\n", argv[0], MAX_THREADS - 4), 1;
+
+    const int events[] = {1, 64, 1024};
+    const int subs[] = {1, 4, 16};
+    const unsigned int costs[] = {0, 200, 2000}; // ns of busy work per handler call
+    int publishers[8], numPublisherSteps = 0; // 1, 2, 4, ... maxPublishers
+    for (int p = 1; p < maxPublishers; p *= 2) publishers[numPublisherSteps++] = p;
+    publishers[numPublisherSteps++] = maxPublishers;
+    int numPoints = 2 * 3 * 3 * 3 * numPublisherSteps, point = 0;
+
+    printf("mode,events,subscribers,handler_ns,publishers,published,seconds,events_per_s,p50_ns,p99_ns,p999_ns,max_ns\n");
+    for (int async = 0; async < 2; async++)
+        for (int e = 0; e < 3; e++)
+            for (int s = 0; s < 3; s++)
+                for (int c = 0; c < 3; c++)
+                    for (int p = 0; p < numPublisherSteps; p++) {
+                        fprintf(stderr, "\r[%3d/%3d] %-5s events:%-4d subs:%-2d cost:%-4uns publishers:%-2d", ++point,
+                                numPoints, async ? "async" : "sync", events[e], subs[s], costs[c], publishers[p]);
+                        run_point(async, events[e], subs[s], costs[c], publishers[p], ms);
+                    }
+    fprintf(stderr, "\n");
+    return 0;
+}
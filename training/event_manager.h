@@ -1,6 +1,13 @@
+#include "event_shm_bus.h" // first: it sets _GNU_SOURCE before any system header
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>   // async dispatch workers (build with -pthread)
+#include <semaphore.h>
+#include <sched.h>     // sched_yield()
+#include <time.h>      // clock_gettime() for queueing latency
 
 // 1. Define the Handler signature
 /**
@@ -17,6 +24,14 @@
  */
 typedef void (*EventHandler)(int eventId, const char* eventName, void* context);
 
+/**
+ * @typedef EventBatchHandler
+ * @brief Optional handler receiving a whole batch of contexts of one event in a single call.
+ *
+ * @param contexts Array of 'count' context pointers, in publication order.
+ */
+typedef void (*EventBatchHandler)(int eventId, const char* eventName, void** contexts, int count);
+
 // 2. Module Structure
 typedef struct {
     char name[50]; // module name
@@ -24,39 +39,367 @@ typedef struct {
     // NOTE: this is a common event handler, 
     // which needs to have seperate blocks of logic for different types of event 
     // (eventName passed as arg to the handler itself)
+    EventBatchHandler handleEventBatch; // optional, NULL => handleEvent is called per context of a batch
 } Module;
 
-// 3. Subscriber Node 
-// (Each event has a linked list of subscribers, 
+// Handler profile of one (event, module) pair: created by start_tracing() (or at subscribe
+// time once tracing was started) and kept (with its numbers) until destroy_manager(),
+// only updated while tracing. Managers that never trace never allocate one.
+#define TRACE_HIST_BUCKETS 40 // log2(ns) buckets of the handler time, up to ~18 minutes
+
+typedef struct HandlerStats {
+    const Module* module;  // identity only, never dereferenced: the module may be freed before the report
+    char moduleName[50];   // copy of module->name for the reports
+    _Atomic unsigned long calls;
+    _Atomic uint64_t totalNs, maxNs;
+    _Atomic unsigned long hist[TRACE_HIST_BUCKETS];
+    struct HandlerStats* next; // next module of the same event
+} HandlerStats;
+
+// 3. Subscriber Entry
+// (Each event keeps its subscribers in one contiguous array of handler + context pairs,
 // subscribers are nothing but different modules subscribing to the event)
-typedef struct SubNode {
-    Module* module;
-    struct SubNode* next;
+// NOTE: an array instead of a linked list => no malloc per registration and dispatch
+// walks consecutive memory (prefetch friendly) instead of chasing a pointer per node
+typedef struct {
+    EventHandler handleEvent; // copy of module->handleEvent, saves a pointer chase per call
+    EventBatchHandler handleEventBatch; // copy of module->handleEventBatch
+    Module* module;           // context of the subscription (name, identity for unregister)
+    int wildcard;             // 1 = added by a topic pattern (subscribe_topic), 0 = register_module_by_*
+    HandlerStats* stats;      // profile of this (event, module) pair, NULL until tracing was first started
 } Subscriber;
 
+#define SUBS_INIT_CAPACITY 8 // reserved per event at create_manager(), doubled when full
+
+// Subscriber snapshot (copy-on-write): dispatchers read it without any lock, writers never
+// modify what a dispatcher may be iterating. Registration appends past numSubs and then
+// publishes the new count (no copy while capacity lasts); unregistering or growing builds
+// a new snapshot, swaps the event's pointer atomically and retires the old one, which is
+// freed once no dispatcher can still be reading it (epoch based reclamation below).
+typedef struct SubscriberSet {
+    _Atomic int numSubs;   // published entries
+    int capSubs;           // allocated entries
+    unsigned long retireEpoch;          // epoch it was replaced in (retired sets only)
+    struct SubscriberSet* nextRetired;
+    Subscriber subs[];     // subscribers array
+} SubscriberSet;
+
+// Priority classes: with async dispatch every class has its own run queue and
+// higher classes are drained first (0 = most urgent)
+typedef enum {
+    PRIORITY_HIGH,   // e.g. security
+    PRIORITY_NORMAL, // default of every event
+    PRIORITY_LOW,    // e.g. analytics, logging
+    PRIORITY_CLASSES
+} EventPriority;
+static const char* PRIORITY_NAMES[PRIORITY_CLASSES] = {"HIGH", "NORMAL", "LOW"};
+
+// Coalescing (set_event_coalescing): triggers of an event with the same key that fall into
+// one window are folded into a single delivery, keeping the newest context or merging them
+typedef uint64_t (*CoalesceKeyFn)(const void* context);       // NULL => one key for the whole event
+typedef void* (*CoalesceMergeFn)(void* pending, void* incoming); // context to keep, NULL fn => last writer wins
+
+typedef enum {
+    COALESCE_WINDOW,   // delivered windowUs after the first trigger of the burst
+    COALESCE_DEBOUNCE  // delivered once no trigger of the key came for windowUs
+} CoalesceMode;
+
+typedef struct {
+    unsigned int windowUs;
+    CoalesceMode mode;
+    CoalesceKeyFn keyOf;
+    CoalesceMergeFn merge;
+} CoalesceConfig;
+
+typedef struct {
+    uint64_t key;
+    void* context;
+    uint64_t deadlineNs;
+    int used;
+} CoalesceEntry;
+
+typedef struct {
+    CoalesceConfig cfg;
+    int eventId;
+    pthread_mutex_t lock;
+    CoalesceEntry* table;    // open addressing (linear probing) on the key, one entry per open window
+    unsigned int mask, count;
+    uint64_t nextDeadlineNs; // earliest deadline of the open windows (a lower bound with debounce)
+    unsigned long triggered, delivered, merged;
+} CoalesceState;
+
+// Context pool (set_event_context_pool): fixed size contexts of one event type carved out of
+// slabs, each with a reference count in front of it. The publisher allocates and fills one,
+// every queued / deferred delivery holds a reference, so the same object is handed to all
+// subscribers (no copy) and goes back to the pool's free list after the last handler ran.
+typedef struct ContextHeader {
+    _Alignas(16) struct ContextPool* pool; // contexts after it stay 16 byte aligned
+    _Atomic int refs;
+    struct ContextHeader* nextFree;
+} ContextHeader;
+
+typedef struct ContextSlab {
+    struct ContextSlab* next;
+    _Alignas(16) unsigned char items[]; // perSlab x (header + context)
+} ContextSlab;
+
+typedef struct ContextPool {
+    size_t contextSize, stride;
+    int perSlab;
+    pthread_mutex_t lock;
+    ContextHeader* freeList;
+    ContextSlab* slabs;       // only grows, freed with the manager
+    unsigned long allocs, inUse, peakInUse, numSlabs;
+} ContextPool;
+
 // 4. Event Structure
 typedef struct {
-    char name[50]; // event name
-    Subscriber* subs; // subscribers linked list
+    char name[50]; // event name (set it with set_event_name(), which keeps the name index in sync)
+    unsigned int nameHash; // hash of name, compared before the strcmp
+    _Atomic(SubscriberSet*) subs; // current snapshot, never NULL
+    EventPriority priority; // run queue used by async dispatch
+    uint32_t contextSize;   // bytes of context copied to out-of-process subscribers (0 = none)
+    HandlerStats* handlerStats; // profiles of every module that ever subscribed
+    CoalesceState* coalesce; // NULL => every trigger is delivered
+    ContextPool* pool;       // non NULL => every context of the event comes from alloc_event_context()
 } Event;
 
+// Topic trie: wildcard subscriptions on hierarchical event names ("user.login", "payment.*").
+// One node per pattern segment, "*" matches exactly one segment and "#" (last segment only)
+// matches all remaining ones, including none. The trie is only walked when a subscription
+// or an event name changes: the modules matching an event are then copied into that event's
+// subscriber array, so dispatch never matches patterns and stays O(subscribers).
+typedef struct TopicNode {
+    char segment[50];             // literal segment, "*" or "#" ("" for the root)
+    struct TopicNode* firstChild;
+    struct TopicNode* nextSibling;
+    Module** mods;                // modules subscribed to the pattern ending here
+    int numMods, capMods;
+} TopicNode;
+
+// One handler call in the trace ring (Chrome trace "complete" event)
+typedef struct {
+    uint64_t startNs, durNs;
+    char moduleName[50]; // copied like eventId, the module may be gone by dump_trace_json()
+    int eventId;
+    int thread; // dispatching thread's epoch slot
+} TraceRecord;
+
 // 4. Event Manager Structure
 typedef struct {
-    Event* events; // Array of linked lists
+    Event* events; // Array of events, each with its subscribers array
     int maxEvents;
+    // name -> id index: open addressing (linear probing) table of eventId+1, 0 = empty slot
+    // sized to a power of 2 >= 2*maxEvents at create_manager(), so it never fills up
+    int* nameIndex;
+    unsigned int indexMask; // table size - 1
+    struct AsyncDispatcher* async; // NULL => handlers run synchronously inside trigger_event_*
+    pthread_mutex_t writeLock;     // serializes subscription changes (dispatch never takes it)
+    SubscriberSet* retired;        // replaced snapshots waiting for their readers to finish
+    TopicNode* topics;             // root of the wildcard subscription trie
+    int numTopicSubs;              // modules subscribed over all patterns
+    ShmBus* shm;                   // NULL => no out-of-process subscribers
+    // tracing (start_tracing): off costs one well predicted branch per handler call
+    _Atomic int tracing;
+    int profiling;                 // tracing was started once: subscribers get a HandlerStats (under writeLock)
+    TraceRecord* traceRing;        // last handler calls (NULL => profile counters only)
+    unsigned long traceMask;       // ring size - 1
+    _Atomic unsigned long traceNext;
+    uint64_t traceStartNs;         // timestamps in the dump are relative to it
+    _Atomic int numCoalescing;     // events with coalescing on (0 => triggers skip the check)
+    _Atomic uint64_t coalesceNextNs; // earliest window to close over all events
+    int verbose;                   // print subscription and dispatch banners (default 1)
 } EventManager;
 
+// --- Epoch Based Reclamation ---
+// Every dispatching thread announces the global epoch in its own (cache line padded) slot
+// while it reads subscriber snapshots, and 0 when it is outside. A snapshot retired in epoch
+// R can only be held by readers that announced an epoch <= R, so it is freed once every
+// announced epoch is > R. Read sections nest (a handler may trigger another event).
+// A thread's slot is handed back when the thread exits, so threads may come and go
+// (e.g. worker pools started and stopped again).
+#define EPOCH_MAX_THREADS 256 // dispatching threads alive at the same time
+
+typedef struct {
+    _Alignas(64) _Atomic unsigned long epoch; // 0 = not reading
+    _Atomic int owned;                        // claimed by a live thread
+} EpochSlot;
+
+static EpochSlot epochSlots[EPOCH_MAX_THREADS];
+static _Atomic unsigned long epochGlobal = 1;
+static _Atomic int epochSlotsUsed = 0; // high-water mark of claimed slots
+static _Thread_local int epochSlot = -1;
+static _Thread_local int epochNesting = 0;
+static pthread_key_t epochKey; // its destructor returns the slot at thread exit
+static pthread_once_t epochKeyOnce = PTHREAD_ONCE_INIT;
+
+// Runs on the exiting thread itself, so its thread locals can be reset here too
+static void epoch_slot_release(void* slot) {
+    EpochSlot* s = (EpochSlot*)slot;
+    atomic_store(&s->epoch, 0); // a thread leaving from inside a handler must not stall synchronize_dispatch()
+    epochSlot = -1;             // a later destructor that dispatches claims a slot again
+    epochNesting = 0;
+    atomic_store(&s->owned, 0);
+}
+
+static void epoch_key_create(void) {
+    pthread_key_create(&epochKey, epoch_slot_release);
+}
+
+static int epoch_slot_claim(void) {
+    pthread_once(&epochKeyOnce, epoch_key_create);
+    for (int i = 0; i < EPOCH_MAX_THREADS; i++) {
+        int expected = 0;
+        if (!atomic_compare_exchange_strong(&epochSlots[i].owned, &expected, 1)) continue;
+        int used = atomic_load(&epochSlotsUsed); // published before the slot's first epoch store
+        while (used < i + 1 && !atomic_compare_exchange_weak(&epochSlotsUsed, &used, i + 1)) {}
+        pthread_setspecific(epochKey, &epochSlots[i]);
+        return i;
+    }
+    fprintf(stderr, "epoch_read_lock: more than %d dispatching threads\n", EPOCH_MAX_THREADS);
+    exit(1);
+}
+
+static inline void epoch_read_lock(void) {
+    if (epochNesting++ > 0) return;
+    if (epochSlot < 0) epochSlot = epoch_slot_claim();
+    // seq_cst store: ordered before the snapshot pointer loads that follow
+    atomic_store(&epochSlots[epochSlot].epoch, atomic_load(&epochGlobal));
+}
+
+static inline void epoch_read_unlock(void) {
+    if (--epochNesting > 0) return;
+    atomic_store_explicit(&epochSlots[epochSlot].epoch, 0, memory_order_release);
+}
+
+// Smallest epoch announced by a thread inside a read section (ULONG_MAX if none)
+static unsigned long epoch_min_active(void) {
+    unsigned long min = (unsigned long)-1;
+    int used = atomic_load(&epochSlotsUsed);
+    for (int i = 0; i < used; i++) {
+        unsigned long e = atomic_load(&epochSlots[i].epoch);
+        if (e != 0 && e < min) min = e;
+    }
+    return min;
+}
+
+// Wait until every dispatch that might still see a replaced snapshot has finished
+// (RCU's synchronize: after unregister + this, the handler is not running anymore).
+// Must not be called from inside a handler.
+void synchronize_dispatch(void) {
+    unsigned long target = atomic_fetch_add(&epochGlobal, 1);
+    while (epoch_min_active() <= target) sched_yield();
+}
+
 // --- Event Manager Functions ---
 // since C dont have class like encapsulation, we internally try to formulate in such manner
 // assume declaration similar to python like self of class object as part of function's arg...
 
+// by-name variants call the by-id ones, which are defined after them
+void register_module_by_id(EventManager* self, int eventId, Module* mod);
+void unregister_module_by_id(EventManager* self, int eventId, Module* mod);
+void trigger_event_by_id(EventManager* self, int eventId, void* context);
+void dispatch_event(EventManager* self, int eventId, void* context);
+int async_enqueue(EventManager* self, int eventId, void* context);
+static void rebuild_topic_subscribers(EventManager* self, Event* ev);
+static void publish_event(EventManager* self, int eventId, void* context);
+
+// FNV-1a over the name
+unsigned int hash_event_name(const char* name) {
+    unsigned int h = 2166136261u;
+    while (*name) {
+        h ^= (unsigned char)*name++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Index slot holding 'name', or the empty slot where it would go
+static int* name_index_slot(EventManager* self, const char* name, unsigned int h) {
+    unsigned int i = h & self->indexMask;
+    while (self->nameIndex[i] != 0) {
+        const Event* ev = &self->events[self->nameIndex[i] - 1];
+        if (ev->nameHash == h && strcmp(ev->name, name) == 0) break;
+        i = (i + 1) & self->indexMask;
+    }
+    return &self->nameIndex[i];
+}
+
+// O(1) on average, no allocation (hash + usually a single strcmp)
 int find_event_id(EventManager* self, const char* eventName) {
-    for(int i=0; i<self->maxEvents; i++) {
-        if (strcmp(self->events[i].name, eventName) == 0) {
-            return i;
+    return self->nameIndex[name_index_slot(self, eventName, hash_event_name(eventName)) - self->nameIndex] - 1;
+}
+
+// Remove the index entry of 'eventId' (backward shift keeps probe chains intact, no tombstones)
+static void name_index_remove(EventManager* self, int eventId) {
+    unsigned int hole = name_index_slot(self, self->events[eventId].name, self->events[eventId].nameHash) - self->nameIndex;
+    if (self->nameIndex[hole] != eventId + 1) return; // a duplicate name indexed by another event
+    unsigned int i = hole;
+    for (;;) {
+        i = (i + 1) & self->indexMask;
+        if (self->nameIndex[i] == 0) break;
+        unsigned int home = self->events[self->nameIndex[i] - 1].nameHash & self->indexMask;
+        if (((i - home) & self->indexMask) >= ((i - hole) & self->indexMask)) { // entry may move back
+            self->nameIndex[hole] = self->nameIndex[i];
+            hole = i;
         }
     }
-    return -1;
+    self->nameIndex[hole] = 0;
+}
+
+// Name (or rename) an event; names should be unique, a duplicate keeps resolving
+// to the event that got it first. Returns -1 for a bad id or a name that does not fit.
+int set_event_name(EventManager* self, int eventId, const char* name) {
+    if (eventId < 0 || eventId >= self->maxEvents || strlen(name) >= sizeof(self->events[0].name)) return -1;
+    Event* ev = &self->events[eventId];
+    if (ev->name[0] != '\0') {
+        name_index_remove(self, eventId);
+        // another event with the old name takes over its index entry
+        for (int i = 0; i < self->maxEvents; i++) {
+            if (i == eventId || self->events[i].nameHash != ev->nameHash || strcmp(self->events[i].name, ev->name) != 0)
+                continue;
+            *name_index_slot(self, ev->name, ev->nameHash) = i + 1;
+            break;
+        }
+    }
+    strcpy(ev->name, name);
+    ev->nameHash = hash_event_name(name);
+    if (self->shm != NULL && eventId < SHM_BUS_MAX_EVENTS) strcpy(self->shm->region->eventNames[eventId], name);
+    if (self->numTopicSubs > 0) { // the new name may match other patterns
+        pthread_mutex_lock(&self->writeLock);
+        rebuild_topic_subscribers(self, ev);
+        pthread_mutex_unlock(&self->writeLock);
+    }
+    if (name[0] == '\0') return 0; // unnamed events are not indexed
+
+    int* slot = name_index_slot(self, name, ev->nameHash);
+    if (*slot == 0) *slot = eventId + 1;
+    return 0;
+}
+
+int set_event_priority(EventManager* self, int eventId, EventPriority priority) {
+    if (eventId < 0 || eventId >= self->maxEvents || priority < 0 || priority >= PRIORITY_CLASSES) return -1;
+    self->events[eventId].priority = priority;
+    return 0;
+}
+
+// Size of the context struct of an event: that many bytes are copied to out-of-process
+// subscribers (so it must be plain data, pointers inside it mean nothing to another process)
+int set_event_context_size(EventManager* self, int eventId, uint32_t size) {
+    if (eventId < 0 || eventId >= self->maxEvents || size > SHM_BUS_MAX_CONTEXT) return -1;
+    self->events[eventId].contextSize = size;
+    return 0;
+}
+
+// Publish to the out-of-process subscribers of 'bus' too (see event_shm_bus.h): every
+// trigger_event_* then copies the context into the rings subscribed to the event,
+// in addition to the in-process dispatch. Event ids >= SHM_BUS_MAX_EVENTS stay local.
+// attach_shm_bus(self, NULL) detaches again.
+void attach_shm_bus(EventManager* self, ShmBus* bus) {
+    self->shm = bus;
+    if (bus == NULL) return;
+    for (int i = 0; i < self->maxEvents && i < SHM_BUS_MAX_EVENTS; i++)
+        strcpy(bus->region->eventNames[i], self->events[i].name);
 }
 
 // C doesnt support polymorphism / fn overloading, fn names are required to be unique
@@ -65,40 +408,832 @@ void register_module_by_name(EventManager* self, const char* eventName, Module*
     register_module_by_id(self, find_event_id(self, eventName), mod);
 }
 
+static SubscriberSet* alloc_subscriber_set(int capacity) {
+    SubscriberSet* set = (SubscriberSet*)malloc(sizeof(SubscriberSet) + capacity * sizeof(Subscriber));
+    if (set == NULL) {
+        perror("alloc_subscriber_set");
+        return NULL;
+    }
+    atomic_init(&set->numSubs, 0);
+    set->capSubs = capacity;
+    set->nextRetired = NULL;
+    return set;
+}
+
+// Profile of (eventId, mod), created on first use once tracing was started, NULL before
+// so untraced managers don't pay an allocation per registration (caller holds writeLock)
+static HandlerStats* handler_stats(EventManager* self, int eventId, Module* mod) {
+    HandlerStats* st = self->events[eventId].handlerStats;
+    while (st != NULL && (st->module != mod || strncmp(st->moduleName, mod->name, sizeof(st->moduleName) - 1) != 0))
+        st = st->next; // the name too: a freed module's address may come back as another module
+    if (st == NULL && self->profiling && (st = (HandlerStats*)calloc(1, sizeof(HandlerStats))) != NULL) {
+        st->module = mod;
+        memcpy(st->moduleName, mod->name, sizeof(st->moduleName));
+        st->moduleName[sizeof(st->moduleName) - 1] = '\0';
+        st->next = self->events[eventId].handlerStats;
+        self->events[eventId].handlerStats = st;
+    }
+    return st;
+}
+
+// Free the retired snapshots no dispatcher can still hold (caller holds writeLock)
+static void reclaim_subscriber_sets(EventManager* self) {
+    unsigned long minActive = epoch_min_active();
+    SubscriberSet** link = &self->retired;
+    while (*link != NULL) {
+        SubscriberSet* set = *link;
+        if (set->retireEpoch < minActive) {
+            *link = set->nextRetired;
+            free(set);
+        }
+        else {
+            link = &set->nextRetired;
+        }
+    }
+}
+
+// Publish 'next' as the event's snapshot and retire the previous one (caller holds writeLock)
+static void replace_subscriber_set(EventManager* self, Event* ev, SubscriberSet* next) {
+    SubscriberSet* old = atomic_exchange(&ev->subs, next);
+    old->retireEpoch = atomic_fetch_add(&epochGlobal, 1); // readers from now on get 'next'
+    old->nextRetired = self->retired;
+    self->retired = old;
+    reclaim_subscriber_sets(self);
+}
+
+static int reserve_subscribers_locked(EventManager* self, Event* ev, int capacity) {
+    SubscriberSet* cur = atomic_load(&ev->subs);
+    if (capacity <= cur->capSubs) return 0;
+    SubscriberSet* next = alloc_subscriber_set(capacity);
+    if (next == NULL) return -1;
+    int n = atomic_load(&cur->numSubs);
+    memcpy(next->subs, cur->subs, n * sizeof(Subscriber));
+    atomic_init(&next->numSubs, n);
+    replace_subscriber_set(self, ev, next);
+    return 0;
+}
+
+// Make room for at least 'capacity' subscribers of an event up front (no-op if already there)
+int reserve_subscribers(EventManager* self, int eventId, int capacity) {
+    if (eventId < 0 || eventId >= self->maxEvents) return -1;
+    pthread_mutex_lock(&self->writeLock);
+    int ret = reserve_subscribers_locked(self, &self->events[eventId], capacity);
+    pthread_mutex_unlock(&self->writeLock);
+    return ret;
+}
+
 void register_module_by_id(EventManager* self, int eventId, Module* mod) {
     if (eventId < 0 || eventId >= self->maxEvents) return;
 
-    Subscriber* newSub = (Subscriber*)malloc(sizeof(Subscriber));
-    newSub->module = mod; // append new sub on top of linked list, T=O(1)
-    newSub->next = self->events[eventId].subs;
-    self->events[eventId].subs = newSub;
-    printf("||>> Module \"%s\" registered >>> event[%d]: %s >>||\n", mod->name, eventId, self->events[eventId].name);
+    Event* ev = &self->events[eventId];
+    pthread_mutex_lock(&self->writeLock);
+    SubscriberSet* cur = atomic_load(&ev->subs);
+    int n = atomic_load(&cur->numSubs);
+    if (n == cur->capSubs) { // full: copy into a snapshot of double the capacity, amortized T=O(1)
+        if (reserve_subscribers_locked(self, ev, cur->capSubs ? cur->capSubs * 2 : SUBS_INIT_CAPACITY) < 0) {
+            pthread_mutex_unlock(&self->writeLock);
+            return;
+        }
+        cur = atomic_load(&ev->subs);
+    }
+    // append at the end of the array, then publish: dispatchers see either n or n+1 entries
+    cur->subs[n].handleEvent = mod->handleEvent;
+    cur->subs[n].handleEventBatch = mod->handleEventBatch;
+    cur->subs[n].module = mod;
+    cur->subs[n].wildcard = 0;
+    cur->subs[n].stats = handler_stats(self, eventId, mod);
+    atomic_store_explicit(&cur->numSubs, n + 1, memory_order_release);
+    pthread_mutex_unlock(&self->writeLock);
+    if (self->verbose) printf("||>> Module \"%s\" registered >>> event[%d]: %s >>||\n", mod->name, eventId, self->events[eventId].name);
 }
 
 void unregister_module_by_name(EventManager* self, const char* eventName, Module* mod) {
     unregister_module_by_id(self, find_event_id(self, eventName), mod);
 }
 
+// Dispatches already running may still call the module once more with the old snapshot;
+// call synchronize_dispatch() afterwards when that matters (e.g. before freeing the module).
 void unregister_module_by_id(EventManager* self, int eventId, Module* mod) {
     if (eventId < 0 || eventId >= self->maxEvents) return;
 
-    Subscriber* iterSub = self->events[eventId].subs;
-    if (iterSub != NULL && iterSub->module == mod) {
-        self->events[eventId].subs = iterSub->next;
-        free(iterSub);
+    Event* ev = &self->events[eventId];
+    pthread_mutex_lock(&self->writeLock);
+    SubscriberSet* cur = atomic_load(&ev->subs);
+    int n = atomic_load(&cur->numSubs);
+    int i = 0;
+    while (i < n && (cur->subs[i].module != mod || cur->subs[i].wildcard)) i++;
+    if (i == n) { // not subscribed (topic subscriptions are removed with unsubscribe_topic())
+        pthread_mutex_unlock(&self->writeLock);
+        return;
     }
-    else {
-        while (iterSub->next != NULL) {
-            if (iterSub->next->module == mod) {
-                Subscriber* temp = iterSub->next;
-                iterSub->next = temp->next;
-                free(temp);
-                break;
+
+    // copy-on-write: the new snapshot keeps everyone else, in the same order
+    SubscriberSet* next = alloc_subscriber_set(cur->capSubs);
+    if (next == NULL) {
+        pthread_mutex_unlock(&self->writeLock);
+        return;
+    }
+    memcpy(next->subs, cur->subs, i * sizeof(Subscriber));
+    memcpy(next->subs + i, cur->subs + i + 1, (n - i - 1) * sizeof(Subscriber));
+    atomic_init(&next->numSubs, n - 1);
+    replace_subscriber_set(self, ev, next);
+    pthread_mutex_unlock(&self->writeLock);
+    if (self->verbose) printf("||<< Module %s unregistered <<< event[%d]: %s <<||\n", mod->name, eventId, self->events[eventId].name);
+}
+
+// --- Topic (Wildcard) Subscriptions ---
+
+#define TOPIC_MAX_SEGMENTS 25 // a 49 char name has at most 25 dot separated segments
+
+// Split "a.b.c" into segment pointers / lengths; -1 on an empty segment ("a..b", ".a", "a.")
+static int split_topic(const char* name, const char** segs, int* lens) {
+    int n = 0;
+    for (;;) {
+        const char* dot = strchr(name, '.');
+        int len = dot ? (int)(dot - name) : (int)strlen(name);
+        if (len == 0 || n == TOPIC_MAX_SEGMENTS) return -1;
+        segs[n] = name;
+        lens[n++] = len;
+        if (!dot) return n;
+        name = dot + 1;
+    }
+}
+
+static int topic_segment_is(const TopicNode* node, const char* seg, int len) {
+    return strncmp(node->segment, seg, len) == 0 && node->segment[len] == '\0';
+}
+
+// Append every module whose pattern matches segs[depth..n) below 'node' (trie order)
+static void topic_collect(const TopicNode* node, const char** segs, const int* lens, int depth, int n,
+                          Module** out, int* numOut) {
+    if (depth == n) {
+        for (int i = 0; i < node->numMods; i++) out[(*numOut)++] = node->mods[i];
+    }
+    for (const TopicNode* child = node->firstChild; child != NULL; child = child->nextSibling) {
+        if (strcmp(child->segment, "#") == 0) { // rest of the name, however long
+            for (int i = 0; i < child->numMods; i++) out[(*numOut)++] = child->mods[i];
+        }
+        else if (depth < n && (strcmp(child->segment, "*") == 0 || topic_segment_is(child, segs[depth], lens[depth]))) {
+            topic_collect(child, segs, lens, depth + 1, n, out, numOut);
+        }
+    }
+}
+
+// Re-derive the wildcard subscribers of one event from the trie (caller holds writeLock).
+// Direct subscribers keep their order and come first; no new snapshot if nothing changed.
+static void rebuild_topic_subscribers(EventManager* self, Event* ev) {
+    const char* segs[TOPIC_MAX_SEGMENTS];
+    int lens[TOPIC_MAX_SEGMENTS];
+    Module** matches = NULL;
+    int numMatches = 0;
+    int n = ev->name[0] != '\0' ? split_topic(ev->name, segs, lens) : -1; // unnamed events match nothing
+    if (n > 0 && self->numTopicSubs > 0) {
+        matches = (Module**)malloc(self->numTopicSubs * sizeof(Module*));
+        if (matches == NULL) {
+            perror("rebuild_topic_subscribers");
+            return;
+        }
+        topic_collect(self->topics, segs, lens, 0, n, matches, &numMatches);
+    }
+
+    SubscriberSet* cur = atomic_load(&ev->subs);
+    int numSubs = atomic_load(&cur->numSubs);
+    int numDirect = 0, w = 0, same = 1;
+    for (int i = 0; i < numSubs; i++) {
+        if (!cur->subs[i].wildcard) numDirect++;
+        else if (w >= numMatches || cur->subs[i].module != matches[w++]) same = 0;
+    }
+    if (same && numDirect + numMatches == numSubs) {
+        free(matches);
+        return;
+    }
+
+    int capacity = cur->capSubs ? cur->capSubs : SUBS_INIT_CAPACITY;
+    while (capacity < numDirect + numMatches) capacity *= 2;
+    SubscriberSet* next = alloc_subscriber_set(capacity);
+    if (next == NULL) {
+        free(matches);
+        return;
+    }
+    int k = 0;
+    for (int i = 0; i < numSubs; i++)
+        if (!cur->subs[i].wildcard) next->subs[k++] = cur->subs[i];
+    for (int i = 0; i < numMatches; i++, k++) {
+        next->subs[k].handleEvent = matches[i]->handleEvent;
+        next->subs[k].handleEventBatch = matches[i]->handleEventBatch;
+        next->subs[k].module = matches[i];
+        next->subs[k].wildcard = 1;
+        next->subs[k].stats = handler_stats(self, (int)(ev - self->events), matches[i]);
+    }
+    atomic_init(&next->numSubs, k);
+    replace_subscriber_set(self, ev, next);
+    free(matches);
+}
+
+// Trie node for 'pattern' (created along the way if 'create'), NULL if absent or invalid
+static TopicNode* topic_node(EventManager* self, const char* pattern, int create) {
+    const char* segs[TOPIC_MAX_SEGMENTS];
+    int lens[TOPIC_MAX_SEGMENTS];
+    int n = split_topic(pattern, segs, lens);
+    if (n < 0 || strlen(pattern) >= sizeof(self->topics->segment)) return NULL;
+    TopicNode* node = self->topics;
+    for (int d = 0; d < n; d++) {
+        if (lens[d] == 1 && segs[d][0] == '#' && d != n - 1) return NULL; // "#" must be the last segment
+        TopicNode** link = &node->firstChild; // siblings in creation order
+        while (*link != NULL && !topic_segment_is(*link, segs[d], lens[d])) link = &(*link)->nextSibling;
+        if (*link == NULL) {
+            if (!create) return NULL;
+            *link = (TopicNode*)calloc(1, sizeof(TopicNode));
+            if (*link == NULL) {
+                perror("topic_node");
+                return NULL;
             }
+            memcpy((*link)->segment, segs[d], lens[d]);
+        }
+        node = *link;
+    }
+    return node;
+}
+
+// Subscribe 'mod' to every event whose name matches 'pattern', now and after later renames,
+// e.g. "payment.*" (payment.success, payment.refund) or "#" (all named events).
+// Returns the number of events currently matched, -1 for an invalid pattern.
+int subscribe_topic(EventManager* self, const char* pattern, Module* mod) {
+    pthread_mutex_lock(&self->writeLock);
+    TopicNode* node = topic_node(self, pattern, 1);
+    if (node == NULL) {
+        pthread_mutex_unlock(&self->writeLock);
+        return -1;
+    }
+    if (node->numMods == node->capMods) {
+        int capacity = node->capMods ? node->capMods * 2 : 4;
+        Module** mods = (Module**)realloc(node->mods, capacity * sizeof(Module*));
+        if (mods == NULL) {
+            perror("subscribe_topic");
+            pthread_mutex_unlock(&self->writeLock);
+            return -1;
+        }
+        node->mods = mods;
+        node->capMods = capacity;
+    }
+    node->mods[node->numMods++] = mod;
+    self->numTopicSubs++;
+
+    int matched = 0;
+    for (int i = 0; i < self->maxEvents; i++) {
+        SubscriberSet* before = atomic_load(&self->events[i].subs);
+        rebuild_topic_subscribers(self, &self->events[i]);
+        if (atomic_load(&self->events[i].subs) != before) matched++;
+    }
+    pthread_mutex_unlock(&self->writeLock);
+    if (self->verbose) printf("||>> Module \"%s\" subscribed >>> topic: %s (%d events) >>||\n", mod->name, pattern, matched);
+    return matched;
+}
+
+// Same caveat as unregister_module_by_id(): see synchronize_dispatch()
+void unsubscribe_topic(EventManager* self, const char* pattern, Module* mod) {
+    pthread_mutex_lock(&self->writeLock);
+    TopicNode* node = topic_node(self, pattern, 0); // emptied nodes stay until destroy_manager()
+    int i = 0;
+    while (node != NULL && i < node->numMods && node->mods[i] != mod) i++;
+    if (node == NULL || i == node->numMods) { // not subscribed
+        pthread_mutex_unlock(&self->writeLock);
+        return;
+    }
+    memmove(node->mods + i, node->mods + i + 1, (node->numMods - i - 1) * sizeof(Module*));
+    node->numMods--;
+    self->numTopicSubs--;
+    for (int e = 0; e < self->maxEvents; e++) rebuild_topic_subscribers(self, &self->events[e]);
+    pthread_mutex_unlock(&self->writeLock);
+    if (self->verbose) printf("||<< Module %s unsubscribed <<< topic: %s <<||\n", mod->name, pattern);
+}
+
+static void free_topic_trie(TopicNode* node) {
+    while (node != NULL) {
+        TopicNode* next = node->nextSibling;
+        free_topic_trie(node->firstChild);
+        free(node->mods);
+        free(node);
+        node = next;
+    }
+}
+
+// Banners on registration and dispatch (the sandbox's narration) on or off, e.g. off for benchmarks
+void set_event_logging(EventManager* self, int enabled) {
+    self->verbose = enabled;
+}
+
+// --- Tracing & Handler Profiling ---
+
+static inline uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void trace_record(EventManager* self, const Subscriber* sub, int eventId, uint64_t startNs, uint64_t durNs) {
+    HandlerStats* st = sub->stats;
+    if (st != NULL) {
+        int b = durNs ? 63 - __builtin_clzll(durNs) : 0;
+        atomic_fetch_add_explicit(&st->hist[b < TRACE_HIST_BUCKETS ? b : TRACE_HIST_BUCKETS - 1], 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->calls, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&st->totalNs, durNs, memory_order_relaxed);
+        uint64_t max = atomic_load_explicit(&st->maxNs, memory_order_relaxed);
+        while (durNs > max && !atomic_compare_exchange_weak(&st->maxNs, &max, durNs)) {}
+    }
+    if (self->traceRing != NULL) { // overwrites the oldest record once full
+        TraceRecord* r = &self->traceRing[atomic_fetch_add_explicit(&self->traceNext, 1, memory_order_relaxed) & self->traceMask];
+        r->startNs = startNs;
+        r->durNs = durNs;
+        memcpy(r->moduleName, sub->module->name, sizeof(r->moduleName));
+        r->eventId = eventId;
+        r->thread = epochSlot;
+    }
+}
+
+// Every handler call goes through here (inside a dispatch's epoch read section)
+static inline void invoke_subscriber(EventManager* self, const Subscriber* sub, int eventId, const char* eventName, void* context) {
+    if (__builtin_expect(atomic_load_explicit(&self->tracing, memory_order_relaxed), 0)) {
+        uint64_t start = monotonic_ns();
+        sub->handleEvent(eventId, eventName, context);
+        trace_record(self, sub, eventId, start, monotonic_ns() - start);
+    }
+    else {
+        sub->handleEvent(eventId, eventName, context);
+    }
+}
+
+static inline void invoke_subscriber_batch(EventManager* self, const Subscriber* sub, int eventId, const char* eventName,
+                                           void** contexts, int count) {
+    if (__builtin_expect(atomic_load_explicit(&self->tracing, memory_order_relaxed), 0)) {
+        uint64_t start = monotonic_ns();
+        sub->handleEventBatch(eventId, eventName, contexts, count);
+        trace_record(self, sub, eventId, start, monotonic_ns() - start); // one call for the whole batch
+    }
+    else {
+        sub->handleEventBatch(eventId, eventName, contexts, count);
+    }
+}
+
+// Give the subscribers of 'ev' that have no profile yet one, in a new snapshot: published
+// ones are never written to (caller holds writeLock)
+static void attach_handler_stats_locked(EventManager* self, Event* ev) {
+    SubscriberSet* cur = atomic_load(&ev->subs);
+    int n = atomic_load(&cur->numSubs), missing = 0;
+    for (int i = 0; i < n; i++) missing |= cur->subs[i].stats == NULL;
+    if (!missing) return;
+    SubscriberSet* next = alloc_subscriber_set(cur->capSubs);
+    if (next == NULL) return;
+    memcpy(next->subs, cur->subs, n * sizeof(Subscriber));
+    for (int i = 0; i < n; i++)
+        if (next->subs[i].stats == NULL)
+            next->subs[i].stats = handler_stats(self, (int)(ev - self->events), next->subs[i].module);
+    atomic_init(&next->numSubs, n);
+    replace_subscriber_set(self, ev, next);
+}
+
+// Start profiling handler calls; traceRecords > 0 also keeps the last that many calls
+// (rounded up to a power of 2) for dump_trace_json(). Counters keep adding up across
+// start/stop. Must not be called from inside a handler.
+int start_tracing(EventManager* self, unsigned long traceRecords) {
+    atomic_store(&self->tracing, 0);
+    synchronize_dispatch(); // no handler call may still write into the old ring
+    free(self->traceRing);
+    self->traceRing = NULL;
+    if (traceRecords > 0) {
+        unsigned long size = 2;
+        while (size < traceRecords) size <<= 1;
+        self->traceRing = (TraceRecord*)calloc(size, sizeof(TraceRecord));
+        if (self->traceRing == NULL) {
+            perror("start_tracing");
+            return -1;
+        }
+        self->traceMask = size - 1;
+    }
+    atomic_store(&self->traceNext, 0);
+    self->traceStartNs = monotonic_ns();
+    pthread_mutex_lock(&self->writeLock);
+    self->profiling = 1; // registrations from now on get their profile right away
+    for (int i = 0; i < self->maxEvents; i++) attach_handler_stats_locked(self, &self->events[i]);
+    pthread_mutex_unlock(&self->writeLock);
+    atomic_store(&self->tracing, 1);
+    return 0;
+}
+
+void stop_tracing(EventManager* self) {
+    atomic_store(&self->tracing, 0);
+}
+
+// Smallest power of 2 >= the value at quantile 'q' of a log2 histogram, capped at 'max'
+static uint64_t log2_hist_percentile(_Atomic unsigned long* hist, int buckets, unsigned long count, double q, uint64_t max) {
+    unsigned long rank = (unsigned long)(q * count), seen = 0;
+    for (int b = 0; b < buckets; b++) {
+        seen += atomic_load(&hist[b]);
+        if (seen > rank) return (2ULL << b) < max ? (2ULL << b) : max;
+    }
+    return max;
+}
+
+static int cmp_handler_total(const void* a, const void* b) {
+    uint64_t x = atomic_load(&(*(HandlerStats* const*)a)->totalNs), y = atomic_load(&(*(HandlerStats* const*)b)->totalNs);
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+// Per (event, module) handler time, most expensive first
+void print_trace_stats(EventManager* self) {
+    int n = 0;
+    for (int e = 0; e < self->maxEvents; e++)
+        for (HandlerStats* st = self->events[e].handlerStats; st != NULL; st = st->next) n++;
+    HandlerStats** rows = (HandlerStats**)malloc((n ? n : 1) * sizeof(HandlerStats*));
+    int* rowEvent = (int*)malloc((n ? n : 1) * sizeof(int));
+    if (rows == NULL || rowEvent == NULL) {
+        perror("print_trace_stats");
+        free(rows);
+        free(rowEvent);
+        return;
+    }
+    n = 0;
+    for (int e = 0; e < self->maxEvents; e++)
+        for (HandlerStats* st = self->events[e].handlerStats; st != NULL; st = st->next)
+            if (atomic_load(&st->calls)) rows[n++] = st;
+    qsort(rows, n, sizeof(HandlerStats*), cmp_handler_total);
+    for (int i = 0; i < n; i++) // event of each row (lists are short, it is a report)
+        for (int e = 0; e < self->maxEvents; e++)
+            for (HandlerStats* st = self->events[e].handlerStats; st != NULL; st = st->next)
+                if (st == rows[i]) rowEvent[i] = e;
+
+    printf("[Trace] %-18s %-18s %8s %10s %9s %9s %9s %9s\n", "EVENT", "MODULE", "CALLS", "TOTAL", "AVG", "P50", "P99", "MAX");
+    for (int i = 0; i < n; i++) {
+        HandlerStats* st = rows[i];
+        unsigned long calls = atomic_load(&st->calls);
+        uint64_t max = atomic_load(&st->maxNs);
+        printf("[Trace] %-18s %-18s %8lu %8.3fms %7.1fus %7.1fus %7.1fus %7.1fus\n", self->events[rowEvent[i]].name,
+               st->moduleName, calls, atomic_load(&st->totalNs) / 1e6, atomic_load(&st->totalNs) / 1e3 / calls,
+               log2_hist_percentile(st->hist, TRACE_HIST_BUCKETS, calls, 0.50, max) / 1e3,
+               log2_hist_percentile(st->hist, TRACE_HIST_BUCKETS, calls, 0.99, max) / 1e3, max / 1e3);
+    }
+    free(rows);
+    free(rowEvent);
+}
+
+// Quoted JSON string of at most 'max' bytes of s (names are user strings: quotes, backslashes, control bytes)
+static void json_write_string(FILE* f, const char* s, size_t max) {
+    fputc('"', f);
+    for (size_t i = 0; i < max && s[i] != '\0'; i++) {
+        unsigned char ch = (unsigned char)s[i];
+        if (ch == '"' || ch == '\\') fprintf(f, "\\%c", ch);
+        else if (ch < 0x20) fprintf(f, "\\u%04x", ch);
+        else fputc(ch, f);
+    }
+    fputc('"', f);
+}
+
+// Write the trace ring as Chrome trace-event JSON (chrome://tracing, Perfetto): one
+// "complete" event per handler call, one track per dispatching thread. Call it while no
+// event is being dispatched, records being overwritten concurrently may come out torn.
+int dump_trace_json(EventManager* self, const char* path) {
+    if (self->traceRing == NULL) return -1;
+    FILE* f = fopen(path, "w");
+    if (f == NULL) {
+        perror("dump_trace_json");
+        return -1;
+    }
+    unsigned long end = atomic_load(&self->traceNext);
+    unsigned long begin = end > self->traceMask + 1 ? end - (self->traceMask + 1) : 0;
+    fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (unsigned long i = begin; i < end; i++) {
+        const TraceRecord* r = &self->traceRing[i & self->traceMask];
+        fprintf(f, "%s\n{\"name\":", i == begin ? "" : ",");
+        json_write_string(f, r->moduleName, sizeof(r->moduleName));
+        fprintf(f, ",\"cat\":");
+        json_write_string(f, self->events[r->eventId].name, sizeof(self->events[r->eventId].name));
+        fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d,\"args\":{\"eventId\":%d}}",
+                (double)(r->startNs - self->traceStartNs) / 1e3, r->durNs / 1e3, (int)getpid(), r->thread, r->eventId);
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+    return (int)(end - begin);
+}
+
+// --- Context Pools ---
+
+static inline ContextHeader* context_header(void* context) {
+    return (ContextHeader*)context - 1;
+}
+
+// Add one slab to the free list (caller holds the pool lock); the only malloc of a pool
+static int context_pool_grow(ContextPool* pool) {
+    size_t bytes = sizeof(ContextSlab) + pool->perSlab * pool->stride;
+    ContextSlab* slab = (ContextSlab*)aligned_alloc(16, (bytes + 15) & ~(size_t)15);
+    if (slab == NULL) {
+        perror("context_pool_grow");
+        return -1;
+    }
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+    for (int i = pool->perSlab - 1; i >= 0; i--) { // lowest address first
+        ContextHeader* h = (ContextHeader*)(slab->items + i * pool->stride);
+        h->pool = pool;
+        h->nextFree = pool->freeList;
+        pool->freeList = h;
+    }
+    pool->numSlabs++;
+    return 0;
+}
+
+// Give an event a pool of 'contextSize' byte contexts, allocated 'perSlab' at a time.
+// From then on all its contexts must come from alloc_event_context() (or be NULL).
+// Small enough contexts are also what the event sends out of process (set_event_context_size).
+int set_event_context_pool(EventManager* self, int eventId, size_t contextSize, int perSlab) {
+    if (eventId < 0 || eventId >= self->maxEvents || self->events[eventId].pool != NULL || contextSize == 0 || perSlab < 1)
+        return -1;
+    ContextPool* pool = (ContextPool*)calloc(1, sizeof(ContextPool));
+    if (pool == NULL) {
+        perror("set_event_context_pool");
+        return -1;
+    }
+    pool->contextSize = contextSize;
+    pool->stride = sizeof(ContextHeader) + ((contextSize + 15) & ~(size_t)15);
+    pool->perSlab = perSlab;
+    pthread_mutex_init(&pool->lock, NULL);
+    if (context_pool_grow(pool) < 0) { // first slab up front
+        pthread_mutex_destroy(&pool->lock);
+        free(pool);
+        return -1;
+    }
+    self->events[eventId].pool = pool;
+    if (contextSize <= SHM_BUS_MAX_CONTEXT) self->events[eventId].contextSize = (uint32_t)contextSize;
+    return 0;
+}
+
+// Zeroed context of the event's type, holding one reference (the caller's): fill it,
+// trigger it, then release_event_context() it. NULL if the event has no pool.
+void* alloc_event_context(EventManager* self, int eventId) {
+    if (eventId < 0 || eventId >= self->maxEvents || self->events[eventId].pool == NULL) return NULL;
+    ContextPool* pool = self->events[eventId].pool;
+    pthread_mutex_lock(&pool->lock);
+    if (pool->freeList == NULL && context_pool_grow(pool) < 0) {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    ContextHeader* h = pool->freeList;
+    pool->freeList = h->nextFree;
+    pool->allocs++;
+    if (++pool->inUse > pool->peakInUse) pool->peakInUse = pool->inUse;
+    pthread_mutex_unlock(&pool->lock);
+    atomic_init(&h->refs, 1);
+    memset(h + 1, 0, pool->contextSize);
+    return h + 1;
+}
+
+void retain_event_context(void* context) {
+    atomic_fetch_add_explicit(&context_header(context)->refs, 1, memory_order_relaxed);
+}
+
+// Drop one reference; the last one returns the context to its pool
+void release_event_context(void* context) {
+    ContextHeader* h = context_header(context);
+    if (atomic_fetch_sub_explicit(&h->refs, 1, memory_order_acq_rel) != 1) return;
+    ContextPool* pool = h->pool;
+    pthread_mutex_lock(&pool->lock);
+    h->nextFree = pool->freeList;
+    pool->freeList = h;
+    pool->inUse--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// References the manager holds while a delivery of a pooled event is queued or deferred
+static inline void hold_event_context(EventManager* self, int eventId, void* context) {
+    if (self->events[eventId].pool != NULL && context != NULL) retain_event_context(context);
+}
+
+static inline void drop_event_context(EventManager* self, int eventId, void* context) {
+    if (self->events[eventId].pool != NULL && context != NULL) release_event_context(context);
+}
+
+void print_context_pools(EventManager* self) {
+    printf("[Pool] %-18s %8s %8s %10s %8s %8s\n", "EVENT", "SIZE", "SLABS", "ALLOCS", "IN USE", "PEAK");
+    for (int i = 0; i < self->maxEvents; i++) {
+        ContextPool* pool = self->events[i].pool;
+        if (pool == NULL) continue;
+        pthread_mutex_lock(&pool->lock);
+        printf("[Pool] %-18s %7zuB %8lu %10lu %8lu %8lu\n", self->events[i].name, pool->contextSize, pool->numSlabs,
+               pool->allocs, pool->inUse, pool->peakInUse);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+static void free_context_pool(ContextPool* pool) {
+    while (pool->slabs != NULL) {
+        ContextSlab* next = pool->slabs->next;
+        free(pool->slabs);
+        pool->slabs = next;
+    }
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+// --- Event Coalescing ---
+// Windows are closed lazily: by any trigger_event_* once the earliest deadline passed, and
+// by flush_coalesced_events() (call it periodically, e.g. from the main loop, if an event may
+// stay quiet for long). So handlers keep running on the publishing thread in sync mode.
+// Contexts must stay valid until their window is delivered, as with async dispatch.
+
+static inline uint64_t coalesce_hash(uint64_t key) { // splitmix64 finalizer
+    key ^= key >> 30; key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27; key *= 0x94d049bb133111ebULL;
+    return key ^ (key >> 31);
+}
+
+static CoalesceEntry* coalesce_slot(CoalesceState* st, uint64_t key) {
+    unsigned int i = (unsigned int)coalesce_hash(key) & st->mask;
+    while (st->table[i].used && st->table[i].key != key) i = (i + 1) & st->mask;
+    return &st->table[i];
+}
+
+static inline void atomic_min_u64(_Atomic uint64_t* target, uint64_t value) {
+    uint64_t cur = atomic_load_explicit(target, memory_order_relaxed);
+    while (value < cur && !atomic_compare_exchange_weak(target, &cur, value)) {}
+}
+
+// Open (or extend) the window of the context's key; returns -1 if it must be delivered right away
+static int coalesce_submit(EventManager* self, CoalesceState* st, void* context) {
+    uint64_t key = st->cfg.keyOf ? st->cfg.keyOf(context) : 0;
+    uint64_t now = monotonic_ns(), deadline = now + st->cfg.windowUs * 1000ULL;
+    int eventId = st->eventId;
+    hold_event_context(self, eventId, context); // the window's reference
+    pthread_mutex_lock(&st->lock);
+    st->triggered++;
+    CoalesceEntry* e = coalesce_slot(st, key);
+    if (e->used) { // burst: fold into the open window (a merge returns one of its arguments)
+        void* pending = e->context;
+        e->context = st->cfg.merge ? st->cfg.merge(pending, context) : context;
+        if (e->context != pending) drop_event_context(self, eventId, pending);
+        if (e->context != context) drop_event_context(self, eventId, context);
+        if (st->cfg.mode == COALESCE_DEBOUNCE) e->deadlineNs = deadline;
+        st->merged++;
+        pthread_mutex_unlock(&st->lock);
+        return 0;
+    }
+    if (2 * (st->count + 1) > st->mask + 1) { // keep the load factor <= 1/2
+        unsigned int size = 2 * (st->mask + 1);
+        CoalesceEntry* old = st->table;
+        CoalesceEntry* table = (CoalesceEntry*)calloc(size, sizeof(CoalesceEntry));
+        if (table == NULL) {
+            perror("coalesce_submit");
+            st->triggered--;
+            pthread_mutex_unlock(&st->lock);
+            drop_event_context(self, eventId, context);
+            return -1;
         }
+        unsigned int oldSize = st->mask + 1;
+        st->table = table;
+        st->mask = size - 1;
+        for (unsigned int i = 0; i < oldSize; i++)
+            if (old[i].used) *coalesce_slot(st, old[i].key) = old[i];
+        free(old);
+        e = coalesce_slot(st, key);
+    }
+    e->used = 1;
+    e->key = key;
+    e->context = context;
+    e->deadlineNs = deadline;
+    st->count++;
+    if (deadline < st->nextDeadlineNs) st->nextDeadlineNs = deadline;
+    pthread_mutex_unlock(&st->lock);
+    atomic_min_u64(&self->coalesceNextNs, deadline);
+    return 0;
+}
+
+// Earliest deadline of the event's open windows, UINT64_MAX if none
+static uint64_t coalesce_next_deadline(CoalesceState* st) {
+    pthread_mutex_lock(&st->lock);
+    uint64_t next = st->count ? st->nextDeadlineNs : UINT64_MAX;
+    pthread_mutex_unlock(&st->lock);
+    return next;
+}
+
+// Deliver the closed windows of one event (all of them if 'force'); returns how many.
+// *nextNs (if not NULL) is lowered to the earliest deadline of the windows left open.
+static int coalesce_flush_event(EventManager* self, int eventId, uint64_t now, int force, uint64_t* nextNs) {
+    CoalesceState* st = self->events[eventId].coalesce;
+    pthread_mutex_lock(&st->lock);
+    if (st->count == 0 || (!force && now < st->nextDeadlineNs)) {
+        if (nextNs != NULL && st->count && st->nextDeadlineNs < *nextNs) *nextNs = st->nextDeadlineNs;
+        pthread_mutex_unlock(&st->lock);
+        return 0;
+    }
+    void** due = (void**)malloc(st->count * sizeof(void*));
+    if (due == NULL) {
+        perror("coalesce_flush_event");
+        pthread_mutex_unlock(&st->lock);
+        return 0;
+    }
+    // take the due entries out, then re-insert the rest (linear probing has no cheap delete)
+    unsigned int size = st->mask + 1, numDue = 0, numKept = 0;
+    CoalesceEntry* kept = (CoalesceEntry*)malloc(st->count * sizeof(CoalesceEntry));
+    if (kept == NULL) {
+        perror("coalesce_flush_event");
+        free(due);
+        pthread_mutex_unlock(&st->lock);
+        return 0;
+    }
+    for (unsigned int i = 0; i < size; i++) {
+        if (!st->table[i].used) continue;
+        if (force || st->table[i].deadlineNs <= now) due[numDue++] = st->table[i].context;
+        else kept[numKept++] = st->table[i];
+        st->table[i].used = 0;
+    }
+    st->nextDeadlineNs = UINT64_MAX;
+    for (unsigned int i = 0; i < numKept; i++) {
+        *coalesce_slot(st, kept[i].key) = kept[i];
+        if (kept[i].deadlineNs < st->nextDeadlineNs) st->nextDeadlineNs = kept[i].deadlineNs;
+    }
+    st->count = numKept;
+    st->delivered += numDue;
+    if (nextNs != NULL && numKept && st->nextDeadlineNs < *nextNs) *nextNs = st->nextDeadlineNs;
+    pthread_mutex_unlock(&st->lock);
+
+    for (unsigned int i = 0; i < numDue; i++) { // outside the lock
+        publish_event(self, eventId, due[i]);
+        drop_event_context(self, eventId, due[i]); // the window's reference
+    }
+    free(kept);
+    free(due);
+    return (int)numDue;
+}
+
+// Deliver every window whose time is up (every open window if 'force'); returns how many
+int flush_coalesced_events(EventManager* self, int force) {
+    if (atomic_load(&self->numCoalescing) == 0) return 0;
+    uint64_t now = monotonic_ns(), next = UINT64_MAX;
+    int delivered = 0;
+    for (int i = 0; i < self->maxEvents; i++)
+        if (self->events[i].coalesce != NULL) delivered += coalesce_flush_event(self, i, now, force, &next);
+    // Publishing 'next' may raise the value over a deadline that a concurrent trigger opened
+    // in an event already visited above; look at every event again after the store, so any
+    // such window is seen here or lowers the value itself (its atomic_min follows our store)
+    atomic_store(&self->coalesceNextNs, next);
+    for (int i = 0; i < self->maxEvents; i++) {
+        CoalesceState* st = self->events[i].coalesce;
+        if (st != NULL) atomic_min_u64(&self->coalesceNextNs, coalesce_next_deadline(st));
+    }
+    return delivered;
+}
+
+// Turn coalescing of an event on (or reconfigure it), cfg NULL turns it off after delivering
+// what is pending. Configure before publishing the event from several threads.
+int set_event_coalescing(EventManager* self, int eventId, const CoalesceConfig* cfg) {
+    if (eventId < 0 || eventId >= self->maxEvents) return -1;
+    Event* ev = &self->events[eventId];
+    if (cfg == NULL) {
+        if (ev->coalesce == NULL) return 0;
+        coalesce_flush_event(self, eventId, monotonic_ns(), 1, NULL);
+        CoalesceState* st = ev->coalesce;
+        ev->coalesce = NULL;
+        atomic_fetch_sub(&self->numCoalescing, 1);
+        pthread_mutex_destroy(&st->lock);
+        free(st->table);
+        free(st);
+        return 0;
+    }
+    if (ev->coalesce != NULL) {
+        pthread_mutex_lock(&ev->coalesce->lock);
+        ev->coalesce->cfg = *cfg;
+        pthread_mutex_unlock(&ev->coalesce->lock);
+        return 0;
+    }
+    CoalesceState* st = (CoalesceState*)calloc(1, sizeof(CoalesceState));
+    CoalesceEntry* table = (CoalesceEntry*)calloc(16, sizeof(CoalesceEntry));
+    if (st == NULL || table == NULL) {
+        perror("set_event_coalescing");
+        free(st);
+        free(table);
+        return -1;
+    }
+    st->cfg = *cfg;
+    st->eventId = eventId;
+    pthread_mutex_init(&st->lock, NULL);
+    st->table = table;
+    st->mask = 15;
+    st->nextDeadlineNs = UINT64_MAX;
+    ev->coalesce = st;
+    atomic_fetch_add(&self->numCoalescing, 1);
+    return 0;
+}
+
+void print_coalesce_stats(EventManager* self) {
+    printf("[Coalesce] %-18s %-8s %9s %10s %10s %8s %10s %6s\n", "EVENT", "MODE", "WINDOW", "TRIGGERED", "DELIVERED",
+           "PENDING", "SAVED", "RATE");
+    for (int i = 0; i < self->maxEvents; i++) {
+        CoalesceState* st = self->events[i].coalesce;
+        if (st == NULL) continue;
+        pthread_mutex_lock(&st->lock);
+        printf("[Coalesce] %-18s %-8s %7.1fms %10lu %10lu %8u %10lu %5.1f%%\n", self->events[i].name,
+               st->cfg.mode == COALESCE_DEBOUNCE ? "debounce" : "window", st->cfg.windowUs / 1e3, st->triggered,
+               st->delivered, st->count, st->merged, st->triggered ? 100.0 * st->merged / st->triggered : 0.0);
+        pthread_mutex_unlock(&st->lock);
     }
-    // linked list --> search and remove, T=O(n)    
-    printf("||<< Module %s unregistered <<< event[%d]: %s <<||\n", mod->name, eventId, self->events[eventId].name);
 }
 
 // note: a module might register for a same event multiple times, 
@@ -109,30 +1244,493 @@ void trigger_event_by_name(EventManager* self, const char* eventName, void* cont
     trigger_event_by_id(self, find_event_id(self, eventName), context);
 }
 
+// Deliver one trigger: out-of-process subscribers, then the worker queue or the handlers
+static void publish_event(EventManager* self, int eventId, void* context) {
+    if (self->shm != NULL) // out-of-process subscribers get a copy of the context
+        shm_bus_publish(self->shm, eventId, context, context ? self->events[eventId].contextSize : 0);
+    if (self->async != NULL) async_enqueue(self, eventId, context); // handled later by a worker
+    else dispatch_event(self, eventId, context);
+}
+
 void trigger_event_by_id(EventManager* self, int eventId, void* context) {
-    const char* eventName = self->events[eventId].name;
-    printf("\n===== Triggering Event[ID:%d] \"%s\" =====\n", eventId, eventName);
-    
-    Subscriber* current = self->events[eventId].subs;
-    if (current == NULL) {
-        printf("No modules registered for this event.\n");
+    if (eventId < 0 || eventId >= self->maxEvents) return;
+    if (atomic_load_explicit(&self->numCoalescing, memory_order_relaxed) > 0) {
+        if (monotonic_ns() >= atomic_load_explicit(&self->coalesceNextNs, memory_order_relaxed))
+            flush_coalesced_events(self, 0);
+        CoalesceState* st = self->events[eventId].coalesce;
+        if (st != NULL && coalesce_submit(self, st, context) == 0) return; // delivered when its window closes
+    }
+    publish_event(self, eventId, context);
+}
+
+// Publish 'count' contexts of one event at once: the banner is printed once per batch and every
+// subscriber gets one call (its batch handler, else its handler once per context, in order).
+// In async mode each context is queued on its own (the array need not outlive the call).
+void trigger_event_batch(EventManager* self, int eventId, void** contexts, int count) {
+    if (eventId < 0 || eventId >= self->maxEvents || count <= 0) return;
+    if (self->events[eventId].coalesce != NULL) { // every context joins its key's window
+        for (int i = 0; i < count; i++) trigger_event_by_id(self, eventId, contexts[i]);
+        return;
+    }
+    if (self->shm != NULL) {
+        for (int i = 0; i < count; i++)
+            shm_bus_publish(self->shm, eventId, contexts[i], contexts[i] ? self->events[eventId].contextSize : 0);
+    }
+    if (self->async != NULL) {
+        for (int i = 0; i < count; i++) async_enqueue(self, eventId, contexts[i]);
         return;
     }
+    const char* eventName = self->events[eventId].name;
+    if (self->verbose) printf("\n===== Triggering Event[ID:%d] \"%s\" x%d (batch) =====\n", eventId, eventName, count);
 
-    while (current != NULL) {
-        printf("--> Notifying Module: %s <--\n", current->module->name);
-        current->module->handleEvent(eventId, eventName, context);
-        current = current->next;
+    epoch_read_lock();
+    const SubscriberSet* set = atomic_load_explicit(&self->events[eventId].subs, memory_order_acquire);
+    const Subscriber* subs = set->subs;
+    int numSubs = atomic_load_explicit(&set->numSubs, memory_order_acquire);
+    if (numSubs == 0) {
+        if (self->verbose) printf("No modules registered for this event.\n");
+        epoch_read_unlock();
+        return;
+    }
+    for (int i = 0; i < numSubs; i++) {
+        if (self->verbose) printf("--> Notifying Module: %s (%d contexts) <--\n", subs[i].module->name, count);
+        if (subs[i].handleEventBatch != NULL) {
+            invoke_subscriber_batch(self, &subs[i], eventId, eventName, contexts, count);
+        }
+        else {
+            for (int c = 0; c < count; c++) invoke_subscriber(self, &subs[i], eventId, eventName, contexts[c]);
+        }
     }
+    epoch_read_unlock();
+}
+
+void trigger_event_batch_by_name(EventManager* self, const char* eventName, void** contexts, int count) {
+    trigger_event_batch(self, find_event_id(self, eventName), contexts, count);
 }
 
 // note: in typical applications, handle-event's context is provided by the event for getting additional information
 // on the changes that have occure, its not taken from external as param, to keep things simple, we are using from fn's arg directly
 
+// --- Async Dispatch (Worker Pool) ---
+// start_async_dispatch() turns trigger_event_* into an enqueue of (eventId, context) on a
+// bounded lock-free MPMC ring (Vyukov's sequence numbered cells); worker threads pop jobs and
+// run dispatch_event(), so a slow handler only delays the workers, never the publisher.
+// Every priority class has its own run queue (ring + spill list); workers always take the
+// highest class with work, except when the oldest job of a lower class has waited longer than
+// that class's maxWaitUs (aging => no starvation under a flood of high priority events).
+// NOTE: the context must stay valid until a worker handled it (stop_async_dispatch() drains).
+
+typedef enum {
+    BACKPRESSURE_BLOCK, // ring full => the publisher waits for a free slot
+    BACKPRESSURE_DROP,  // ring full => the event is dropped (counted in stats.dropped)
+    BACKPRESSURE_SPILL  // ring full => the event goes to an unbounded overflow list (FIFO order is lost)
+} BackpressurePolicy;
+
+typedef struct {
+    int numWorkers;         // worker threads
+    int queueCapacity;      // ring slots per priority class, rounded up to a power of 2
+    BackpressurePolicy policy;
+    int serializeModules;   // 1 => one module never runs two handlers at once (across workers)
+    unsigned int maxWaitUs[PRIORITY_CLASSES]; // starvation bound per class, 0 = strict priority
+} AsyncConfig;
+
+typedef struct {
+    _Atomic size_t seq;     // == position: free for the producer of it, == position+1: filled
+    int eventId;
+    void* context;
+    _Atomic uint64_t enqueuedNs; // peeked by workers checking for starvation
+} AsyncCell;
+
+typedef struct SpillNode {
+    int eventId;
+    void* context;
+    uint64_t enqueuedNs;
+    struct SpillNode* next;
+} SpillNode;
+
+#define ASYNC_MODULE_LOCKS 64 // modules are mapped onto a striped lock table
+#define CACHE_LINE 64
+#define WAIT_HIST_BUCKETS 40  // log2(ns) buckets of the queueing latency, up to ~18 minutes
+
+typedef struct {
+    AsyncCell* cells;
+    size_t mask;
+    // producers and consumers each own a cache line, so they don't invalidate each other
+    _Alignas(CACHE_LINE) _Atomic size_t enqueuePos;
+    _Alignas(CACHE_LINE) _Atomic size_t dequeuePos;
+    _Alignas(CACHE_LINE) sem_t slots;   // free ring cells
+    pthread_mutex_t spillLock;
+    SpillNode *spillHead, *spillTail;
+    _Atomic uint64_t spillOldestNs;     // spillHead's enqueue time, 0 if empty (set under spillLock)
+    // metrics
+    _Alignas(CACHE_LINE) _Atomic long depth, maxDepth; // queued jobs (ring + spill)
+    _Atomic unsigned long enqueued, dropped, spilled, handled, aged;
+    _Atomic uint64_t waitTotalNs, waitMaxNs;
+    _Atomic unsigned long waitHist[WAIT_HIST_BUCKETS];
+} RunQueue;
+
+struct AsyncDispatcher {
+    RunQueue queues[PRIORITY_CLASSES];
+    _Alignas(CACHE_LINE) sem_t items;   // jobs waiting in all run queues
+    pthread_mutex_t moduleLocks[ASYNC_MODULE_LOCKS];
+    AsyncConfig cfg;
+    pthread_t* workers;
+    _Atomic int stopping;
+};
+
+static int ring_push(RunQueue* q, int eventId, void* context, uint64_t nowNs) {
+    size_t pos = atomic_load_explicit(&q->enqueuePos, memory_order_relaxed);
+    for (;;) {
+        AsyncCell* cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->enqueuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                cell->eventId = eventId;
+                cell->context = context;
+                atomic_store_explicit(&cell->enqueuedNs, nowNs, memory_order_relaxed);
+                atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+                return 0;
+            }
+        }
+        else if (diff < 0) return -1; // full
+        else pos = atomic_load_explicit(&q->enqueuePos, memory_order_relaxed);
+    }
+}
+
+static int ring_pop(RunQueue* q, int* eventId, void** context, uint64_t* enqueuedNs) {
+    size_t pos = atomic_load_explicit(&q->dequeuePos, memory_order_relaxed);
+    for (;;) {
+        AsyncCell* cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->dequeuePos, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                *eventId = cell->eventId;
+                *context = cell->context;
+                *enqueuedNs = atomic_load_explicit(&cell->enqueuedNs, memory_order_relaxed);
+                atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+                return 0;
+            }
+        }
+        else if (diff < 0) return -1; // empty
+        else pos = atomic_load_explicit(&q->dequeuePos, memory_order_relaxed);
+    }
+}
+
+// Enqueue time of the oldest job in the ring, 0 if none (a racy peek, only used for aging)
+static uint64_t ring_oldest_ns(RunQueue* q) {
+    size_t pos = atomic_load_explicit(&q->dequeuePos, memory_order_relaxed);
+    AsyncCell* cell = &q->cells[pos & q->mask];
+    if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1) return 0;
+    return atomic_load_explicit(&cell->enqueuedNs, memory_order_relaxed);
+}
+
+// Enqueue time of the oldest job of run queue 'q', ring or spill list, 0 if none
+static uint64_t run_queue_oldest_ns(RunQueue* q) {
+    uint64_t ring = ring_oldest_ns(q);
+    uint64_t spill = atomic_load_explicit(&q->spillOldestNs, memory_order_relaxed);
+    if (ring == 0) return spill;
+    return (spill != 0 && spill < ring) ? spill : ring;
+}
+
+static int spill_pop(RunQueue* q, int* eventId, void** context, uint64_t* enqueuedNs) {
+    pthread_mutex_lock(&q->spillLock);
+    SpillNode* node = q->spillHead;
+    if (node != NULL) {
+        q->spillHead = node->next;
+        if (q->spillHead == NULL) q->spillTail = NULL;
+        atomic_store_explicit(&q->spillOldestNs, q->spillHead ? q->spillHead->enqueuedNs : 0, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&q->spillLock);
+    if (node == NULL) return -1;
+    *eventId = node->eventId;
+    *context = node->context;
+    *enqueuedNs = node->enqueuedNs;
+    free(node);
+    return 0;
+}
+
+// Take one job from run queue 'q': the ring first, unless the spill list holds an older job
+// (so spilled jobs don't wait behind a ring that keeps refilling)
+static int run_queue_pop(RunQueue* q, int* eventId, void** context, uint64_t* enqueuedNs) {
+    uint64_t spillOldest = atomic_load_explicit(&q->spillOldestNs, memory_order_relaxed);
+    if (spillOldest != 0) {
+        uint64_t ringOldest = ring_oldest_ns(q);
+        if ((ringOldest == 0 || spillOldest < ringOldest) && spill_pop(q, eventId, context, enqueuedNs) == 0)
+            return 0;
+    }
+    if (ring_pop(q, eventId, context, enqueuedNs) == 0) {
+        sem_post(&q->slots);
+        return 0;
+    }
+    return spill_pop(q, eventId, context, enqueuedNs);
+}
+
+static void run_queue_record_wait(RunQueue* q, uint64_t waitNs) {
+    int b = waitNs ? 63 - __builtin_clzll(waitNs) : 0;
+    atomic_fetch_add_explicit(&q->waitHist[b < WAIT_HIST_BUCKETS ? b : WAIT_HIST_BUCKETS - 1], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&q->waitTotalNs, waitNs, memory_order_relaxed);
+    uint64_t max = atomic_load_explicit(&q->waitMaxNs, memory_order_relaxed);
+    while (waitNs > max && !atomic_compare_exchange_weak(&q->waitMaxNs, &max, waitNs)) {}
+    atomic_fetch_sub_explicit(&q->depth, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&q->handled, 1, memory_order_relaxed);
+}
+
+// Runs the subscribers of one event; used directly (sync) or by the workers (async)
+void dispatch_event(EventManager* self, int eventId, void* context) {
+    const char* eventName = self->events[eventId].name;
+    if (self->verbose) printf("\n===== Triggering Event[ID:%d] \"%s\" =====\n", eventId, eventName);
+    
+    epoch_read_lock(); // the snapshot stays valid until the unlock, whatever writers do
+    const SubscriberSet* set = atomic_load_explicit(&self->events[eventId].subs, memory_order_acquire);
+    const Subscriber* subs = set->subs;
+    int numSubs = atomic_load_explicit(&set->numSubs, memory_order_acquire);
+    if (numSubs == 0) {
+        if (self->verbose) printf("No modules registered for this event.\n");
+        epoch_read_unlock();
+        return;
+    }
+
+    struct AsyncDispatcher* d = self->async;
+    // subscribers are notified in registration order
+    for (int i = 0; i < numSubs; i++) {
+        if (self->verbose) printf("--> Notifying Module: %s <--\n", subs[i].module->name);
+        if (d != NULL && d->cfg.serializeModules) {
+            pthread_mutex_t* lock = &d->moduleLocks[((uintptr_t)subs[i].module >> 4) % ASYNC_MODULE_LOCKS];
+            pthread_mutex_lock(lock);
+            invoke_subscriber(self, &subs[i], eventId, eventName, context);
+            pthread_mutex_unlock(lock);
+        }
+        else {
+            invoke_subscriber(self, &subs[i], eventId, eventName, context);
+        }
+    }
+    epoch_read_unlock();
+}
+
+// Pick the next job: a starving lower class first (oldest over its maxWaitUs), else the
+// highest priority class that has one. Returns the class, -1 if every queue looked empty.
+static int async_next_job(struct AsyncDispatcher* d, int* eventId, void** context, uint64_t* enqueuedNs) {
+    uint64_t now = 0;
+    for (int c = PRIORITY_CLASSES - 1; c > 0; c--) { // lowest class first: it starves first
+        if (d->cfg.maxWaitUs[c] == 0) continue;
+        uint64_t oldest = run_queue_oldest_ns(&d->queues[c]); // spilled jobs age too
+        if (oldest == 0) continue;
+        if (now == 0) now = monotonic_ns();
+        if (now > oldest && now - oldest > (uint64_t)d->cfg.maxWaitUs[c] * 1000 &&
+            run_queue_pop(&d->queues[c], eventId, context, enqueuedNs) == 0) {
+            atomic_fetch_add_explicit(&d->queues[c].aged, 1, memory_order_relaxed);
+            return c;
+        }
+    }
+    for (int c = 0; c < PRIORITY_CLASSES; c++)
+        if (run_queue_pop(&d->queues[c], eventId, context, enqueuedNs) == 0) return c;
+    return -1;
+}
+
+static void* async_worker(void* arg) {
+    EventManager* self = (EventManager*)arg;
+    struct AsyncDispatcher* d = self->async;
+    for (;;) {
+        sem_wait(&d->items); // one job is ours, in one of the run queues (or a stop wakeup)
+        int eventId, cls;
+        void* context;
+        uint64_t enqueuedNs;
+        while ((cls = async_next_job(d, &eventId, &context, &enqueuedNs)) < 0) {
+            if (atomic_load(&d->stopping)) return NULL; // drained, no more publishers
+        }
+        uint64_t now = monotonic_ns();
+        run_queue_record_wait(&d->queues[cls], now > enqueuedNs ? now - enqueuedNs : 0);
+        dispatch_event(self, eventId, context);
+        drop_event_context(self, eventId, context); // the queued job's reference
+    }
+}
+
+// Enqueue for the workers on the event's priority run queue; returns 0 if queued, -1 if dropped
+int async_enqueue(EventManager* self, int eventId, void* context) {
+    struct AsyncDispatcher* d = self->async;
+    RunQueue* q = &d->queues[self->events[eventId].priority];
+    int haveSlot = 1;
+    if (d->cfg.policy == BACKPRESSURE_BLOCK) {
+        while (sem_wait(&q->slots) != 0) {} // retry on EINTR
+    }
+    else if (sem_trywait(&q->slots) != 0) {
+        haveSlot = 0;
+        if (d->cfg.policy == BACKPRESSURE_DROP) {
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+        SpillNode* node = (SpillNode*)malloc(sizeof(SpillNode));
+        if (node == NULL) { // no memory to spill into: dropped, like under BACKPRESSURE_DROP
+            perror("async_enqueue");
+            atomic_fetch_add_explicit(&q->dropped, 1, memory_order_relaxed);
+            return -1;
+        }
+        hold_event_context(self, eventId, context); // released by the worker after the handlers ran
+        node->eventId = eventId;
+        node->context = context;
+        node->enqueuedNs = monotonic_ns();
+        node->next = NULL;
+        pthread_mutex_lock(&q->spillLock);
+        if (q->spillTail != NULL) q->spillTail->next = node;
+        else {
+            q->spillHead = node;
+            atomic_store_explicit(&q->spillOldestNs, node->enqueuedNs, memory_order_relaxed);
+        }
+        q->spillTail = node;
+        pthread_mutex_unlock(&q->spillLock);
+        atomic_fetch_add_explicit(&q->spilled, 1, memory_order_relaxed);
+    }
+    if (haveSlot) {
+        hold_event_context(self, eventId, context);
+        while (ring_push(q, eventId, context, monotonic_ns()) != 0) {} // a slot is reserved, only a racing pop can delay us
+    }
+    atomic_fetch_add_explicit(&q->enqueued, 1, memory_order_relaxed);
+    long depth = atomic_fetch_add_explicit(&q->depth, 1, memory_order_relaxed) + 1;
+    long maxDepth = atomic_load_explicit(&q->maxDepth, memory_order_relaxed);
+    while (depth > maxDepth && !atomic_compare_exchange_weak(&q->maxDepth, &maxDepth, depth)) {}
+    sem_post(&d->items);
+    return 0;
+}
+
+int start_async_dispatch(EventManager* self, const AsyncConfig* cfg) {
+    if (self->async != NULL || cfg->numWorkers < 1 || cfg->queueCapacity < 1) return -1;
+    struct AsyncDispatcher* d = (struct AsyncDispatcher*)aligned_alloc(CACHE_LINE,
+        (sizeof(struct AsyncDispatcher) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    if (d == NULL) return -1;
+    memset(d, 0, sizeof(*d));
+    size_t capacity = 1;
+    while (capacity < (size_t)cfg->queueCapacity) capacity <<= 1;
+    d->workers = (pthread_t*)calloc(cfg->numWorkers, sizeof(pthread_t));
+    for (int c = 0; c < PRIORITY_CLASSES; c++)
+        d->queues[c].cells = (AsyncCell*)calloc(capacity, sizeof(AsyncCell));
+    for (int c = 0; c < PRIORITY_CLASSES; c++) {
+        if (d->workers != NULL && d->queues[c].cells != NULL) continue;
+        for (int k = 0; k < PRIORITY_CLASSES; k++) free(d->queues[k].cells);
+        free(d->workers);
+        free(d);
+        return -1;
+    }
+    for (int c = 0; c < PRIORITY_CLASSES; c++) {
+        RunQueue* q = &d->queues[c];
+        q->mask = capacity - 1;
+        for (size_t i = 0; i < capacity; i++) atomic_init(&q->cells[i].seq, i);
+        sem_init(&q->slots, 0, (unsigned int)capacity);
+        pthread_mutex_init(&q->spillLock, NULL);
+    }
+    sem_init(&d->items, 0, 0);
+    for (int i = 0; i < ASYNC_MODULE_LOCKS; i++) pthread_mutex_init(&d->moduleLocks[i], NULL);
+    d->cfg = *cfg;
+    d->cfg.queueCapacity = (int)capacity;
+
+    self->async = d;
+    for (int i = 0; i < cfg->numWorkers; i++)
+        pthread_create(&d->workers[i], NULL, async_worker, self);
+    return 0;
+}
+
+// Per class queue metrics: depth, queueing latency (enqueue -> handlers start) percentiles
+void print_async_stats(EventManager* self) {
+    struct AsyncDispatcher* d = self->async;
+    if (d == NULL) return;
+    printf("[Async] %-8s %9s %8s %7s %6s %9s %9s %9s %9s %9s\n", "CLASS", "ENQUEUED", "SPILLED", "DROPPED",
+           "AGED", "MAXDEPTH", "WAIT-AVG", "WAIT-P50", "WAIT-P99", "WAIT-MAX");
+    for (int c = 0; c < PRIORITY_CLASSES; c++) {
+        RunQueue* q = &d->queues[c];
+        unsigned long handled = atomic_load(&q->handled);
+        uint64_t max = atomic_load(&q->waitMaxNs);
+        uint64_t pct[2] = {log2_hist_percentile(q->waitHist, WAIT_HIST_BUCKETS, handled, 0.50, max),
+                           log2_hist_percentile(q->waitHist, WAIT_HIST_BUCKETS, handled, 0.99, max)};
+        printf("[Async] %-8s %9lu %8lu %7lu %6lu %9ld %7.1fus %7.1fus %7.1fus %7.1fus\n", PRIORITY_NAMES[c],
+               atomic_load(&q->enqueued), atomic_load(&q->spilled), atomic_load(&q->dropped), atomic_load(&q->aged),
+               atomic_load(&q->maxDepth), handled ? atomic_load(&q->waitTotalNs) / 1e3 / handled : 0.0,
+               pct[0] / 1e3, pct[1] / 1e3, max / 1e3);
+    }
+}
+
+// Drain the queue, join the workers and go back to synchronous dispatch
+void stop_async_dispatch(EventManager* self) {
+    struct AsyncDispatcher* d = self->async;
+    if (d == NULL) return;
+    // one extra wakeup per worker: a worker exits once it wakes up to empty queues,
+    // so every pending job is still handled (publishers must have stopped triggering)
+    atomic_store(&d->stopping, 1);
+    for (int i = 0; i < d->cfg.numWorkers; i++) sem_post(&d->items);
+    for (int i = 0; i < d->cfg.numWorkers; i++) pthread_join(d->workers[i], NULL);
+
+    if (self->verbose) print_async_stats(self);
+    self->async = NULL;
+    sem_destroy(&d->items);
+    for (int c = 0; c < PRIORITY_CLASSES; c++) {
+        sem_destroy(&d->queues[c].slots);
+        pthread_mutex_destroy(&d->queues[c].spillLock);
+        free(d->queues[c].cells);
+    }
+    for (int i = 0; i < ASYNC_MODULE_LOCKS; i++) pthread_mutex_destroy(&d->moduleLocks[i]);
+    free(d->workers);
+    free(d);
+}
+
 // Init Fn()
 EventManager* create_manager(int numEvents) {
     EventManager* em = (EventManager*)malloc(sizeof(EventManager));
     em->maxEvents = numEvents;
     em->events = (Event*)calloc(numEvents, sizeof(Event));
+    for (int i = 0; i < numEvents; i++) { // pre-reserve, so typical registrations never allocate
+        atomic_init(&em->events[i].subs, alloc_subscriber_set(SUBS_INIT_CAPACITY));
+        em->events[i].priority = PRIORITY_NORMAL;
+    }
+    pthread_mutex_init(&em->writeLock, NULL);
+    em->retired = NULL;
+    em->topics = (TopicNode*)calloc(1, sizeof(TopicNode));
+    em->numTopicSubs = 0;
+    em->shm = NULL;
+    atomic_init(&em->tracing, 0);
+    em->profiling = 0;
+    em->traceRing = NULL;
+    em->traceMask = 0;
+    atomic_init(&em->traceNext, 0);
+    em->traceStartNs = 0;
+    atomic_init(&em->numCoalescing, 0);
+    atomic_init(&em->coalesceNextNs, UINT64_MAX);
+    em->verbose = 1;
+
+    unsigned int indexSize = 8; // load factor <= 1/2 keeps probe chains short
+    while (indexSize < 2u * numEvents) indexSize <<= 1;
+    em->nameIndex = (int*)calloc(indexSize, sizeof(int));
+    em->indexMask = indexSize - 1;
+    em->async = NULL;
     return em;
+}
+
+// Cleanup Fn()
+void destroy_manager(EventManager* self) {
+    for (int i = 0; i < self->maxEvents; i++) set_event_coalescing(self, i, NULL); // delivers open windows
+    stop_async_dispatch(self);
+    // no dispatcher may run anymore, so retired snapshots can go regardless of epochs
+    for (int i = 0; i < self->maxEvents; i++)
+        free(atomic_load(&self->events[i].subs));
+    while (self->retired != NULL) {
+        SubscriberSet* next = self->retired->nextRetired;
+        free(self->retired);
+        self->retired = next;
+    }
+    pthread_mutex_destroy(&self->writeLock);
+    free_topic_trie(self->topics);
+    for (int i = 0; i < self->maxEvents; i++) {
+        while (self->events[i].handlerStats != NULL) {
+            HandlerStats* next = self->events[i].handlerStats->next;
+            free(self->events[i].handlerStats);
+            self->events[i].handlerStats = next;
+        }
+    }
+    free(self->traceRing);
+    for (int i = 0; i < self->maxEvents; i++)
+        if (self->events[i].pool != NULL) free_context_pool(self->events[i].pool);
+    free(self->events);
+    free(self->nameIndex);
+    free(self);
 }
\ No newline at end of file
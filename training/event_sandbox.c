@@ -1,5 +1,7 @@
+// gcc event_sandbox.c -pthread
 #include "event_manager.h"
 #include <time.h>
+#include <sys/wait.h>
 
 typedef enum {
     EVENT_USER_LOGIN = 0,
@@ -9,10 +11,11 @@ typedef enum {
 } EventType;
 
 // String mapping: Must match the order of the enum above
+// (hierarchical "domain.action" names, so modules can subscribe to topics like "payment.*")
 const char* EVENT_NAMES[] = {
-    "U_LOGIN",
-    "PAYMENT",
-    "S_LOGOT"
+    "user.login",
+    "payment.success",
+    "system.logout"
 };
 
 
@@ -60,47 +63,62 @@ void analytics_logic(int eventId, const char* eventName, void* ctx) {
     analytic_counter[eventId]++;
     printf(" Updated [event:count] --> ");
     for (int i=0; i<MAX_EVENTS; i++)
-        printf("%7s:%d, ", EVENT_NAMES[i], analytic_counter[i]);
+        printf("%s:%d, ", EVENT_NAMES[i], analytic_counter[i]);
     printf("\n");
 }
 
+// batch variant: one counter update & one line for the whole batch
+void analytics_batch_logic(int eventId, const char* eventName, void** ctxs, int count) {
+    analytic_counter[eventId] += count;
+    printf("[Analytics] %d x %s in one batch, counter now %d\n", count, eventName, analytic_counter[eventId]);
+}
+
+// coalescing key of a login: the user (a burst of one user's logins is handled once)
+uint64_t login_user_key(const void* ctx) {
+    return hash_event_name(((const LoginContext*)ctx)->username);
+}
+
 // --- 3. Application Main ---
 
 int main() {
     // Initialize Manager with 3 Events
     EventManager* em = create_manager(MAX_EVENTS);
-    // Map Enum Strings to the Manager's internal Event structs
+    // Map Enum Strings to the Manager's internal Event structs (and its name -> id index)
     for (int i = 0; i < MAX_EVENTS; i++) {
-        strcpy(em->events[i].name, EVENT_NAMES[i]);
+        set_event_name(em, i, EVENT_NAMES[i]);
     }
+    // QoS: security relevant logins before everything else, logouts last (matters with async dispatch)
+    set_event_priority(em, EVENT_USER_LOGIN, PRIORITY_HIGH);
+    set_event_priority(em, EVENT_SYSTEM_LOGOUT, PRIORITY_LOW);
 
     // Define 4 Modules
     Module modAudit = {"AuditModule", audit_logic};
     Module modSecurity = {"SecurityModule", security_logic};
     Module modBilling = {"BillingModule", billing_logic};
-    Module modAnalytics = {"AnalyticsModule", analytics_logic};
+    Module modAnalytics = {"AnalyticsModule", analytics_logic, analytics_batch_logic};
 
     // Subscriptions
-    // here audit & analytics modules subscribe to all events above
     // security module subs only to login and billing module subs only to payment
-
-    register_module_by_id(em, EVENT_USER_LOGIN, &modAudit);
-    register_module_by_id(em, EVENT_PAYMENT_SUCCESS, &modAudit);
-    register_module_by_id(em, EVENT_SYSTEM_LOGOUT, &modAudit);
-
     register_module_by_id(em, EVENT_USER_LOGIN, &modSecurity);
     
     register_module_by_id(em, EVENT_PAYMENT_SUCCESS, &modBilling);
+
+    // here audit & analytics modules subscribe to all events above with one topic subscription each
+    // ("#" = every event, "*" = any one segment), instead of one registration per event
+    subscribe_topic(em, "#", &modAudit);
+    subscribe_topic(em, "*.*", &modAnalytics);
     
-    register_module_by_id(em, EVENT_USER_LOGIN, &modAnalytics);
-    register_module_by_id(em, EVENT_PAYMENT_SUCCESS, &modAnalytics);
-    register_module_by_id(em, EVENT_SYSTEM_LOGOUT, &modAnalytics);
-    
+
+    // profile every handler call from here on, keeping the last 256 calls for a trace dump
+    start_tracing(em, 256);
 
     // --- CASE 1: A User Logs In (multiple attempts) ---
     LoginContext user1 = {"Alice_99", 0};
     trigger_event_by_id(em, EVENT_USER_LOGIN, &user1); // efficient
-    unregister_module_by_id(em, EVENT_USER_LOGIN, &modAnalytics); // remove analytics observer from login event for testing
+    // remove analytics observer from login event for testing: narrow its topics to everything but "user.*"
+    unsubscribe_topic(em, "*.*", &modAnalytics);
+    subscribe_topic(em, "payment.*", &modAnalytics);
+    subscribe_topic(em, "system.*", &modAnalytics);
     trigger_event_by_id(em, EVENT_USER_LOGIN, &user1);
     trigger_event_by_name(em, EVENT_NAMES[EVENT_USER_LOGIN], &user1); // extra fn-ality
 
@@ -110,5 +128,75 @@ int main() {
 
     // --- CASE 3: System Logout ---
     trigger_event_by_id(em, EVENT_SYSTEM_LOGOUT, NULL);
+
+    // --- CASE 4: Batched Publication ---
+    // Audit has no batch handler (called per context), Analytics handles the batch in one call
+    void* logouts[4] = {NULL, NULL, NULL, NULL};
+    trigger_event_batch(em, EVENT_SYSTEM_LOGOUT, logouts, 4);
+
+    // --- CASE 5: Async Dispatch ---
+    // publisher only enqueues; 2 workers run the handlers, a module never runs on both at once,
+    // queued logins go first, a queued logout waits at most ~50ms behind higher classes
+    AsyncConfig async = {2, 64, BACKPRESSURE_BLOCK, 1, {0, 0, 50000}};
+    // queued payments outlive this scope: they come from the event's context pool, the queued
+    // job holds a reference and the context goes back to the pool after the last handler
+    set_event_context_pool(em, EVENT_PAYMENT_SUCCESS, sizeof(PaymentContext), 16);
+    start_async_dispatch(em, &async);
+    PaymentContext purchases[3] = {{10.00, "USD", "TXN-77822"}, {20.00, "EUR", "TXN-77823"}, {30.00, "INR", "TXN-77824"}};
+    trigger_event_by_id(em, EVENT_SYSTEM_LOGOUT, NULL);
+    for (int i = 0; i < 3; i++) {
+        PaymentContext* payment = (PaymentContext*)alloc_event_context(em, EVENT_PAYMENT_SUCCESS);
+        *payment = purchases[i];
+        trigger_event_by_id(em, EVENT_PAYMENT_SUCCESS, payment);
+        release_event_context(payment); // our reference, the queue keeps its own
+    }
+    trigger_event_by_id(em, EVENT_USER_LOGIN, &user1);
+    stop_async_dispatch(em); // waits until every queued event was handled
+    print_context_pools(em);
+
+    // --- CASE 6: Out-of-Process Module ---
+    // a forked "remote" security module reads logins from its own ring in shared memory;
+    // each trigger copies the LoginContext into that ring besides the local dispatch
+    ShmBus* bus = shm_bus_create(NULL, 64);
+    set_event_context_size(em, EVENT_USER_LOGIN, sizeof(LoginContext));
+    attach_shm_bus(em, bus);
+    int ring = shm_bus_subscribe(bus, "RemoteSecurity", 1ULL << EVENT_USER_LOGIN);
+    fflush(stdout); // or the child would print the parent's buffered output again
+    pid_t child = fork();
+    if (child == 0) {
+        LoginContext remote;
+        int eventId;
+        while (shm_bus_receive(bus, ring, &eventId, &remote, sizeof(remote), -1) >= 0) {
+            printf("[Remote pid:%d] ", (int)getpid());
+            security_logic(eventId, shm_bus_event_name(bus, eventId), &remote); // works on its own copy
+        }
+        fflush(stdout);
+        _exit(0);
+    }
+    LoginContext user2 = {"Bob_42", 0};
+    trigger_event_by_id(em, EVENT_USER_LOGIN, &user2);
+    trigger_event_by_id(em, EVENT_USER_LOGIN, &user2);
+    shm_bus_unsubscribe(bus, ring); // the child drains its ring and exits
+    waitpid(child, NULL, 0);
+    print_shm_bus_stats(bus);
+    attach_shm_bus(em, NULL);
+    shm_bus_close(bus);
+
+    // --- CASE 7: Login Burst Coalescing ---
+    // repeated logins of one user within 20ms reach the handlers once (newest context wins)
+    CoalesceConfig burst = {20000, COALESCE_WINDOW, login_user_key, NULL};
+    set_event_coalescing(em, EVENT_USER_LOGIN, &burst);
+    for (int i = 0; i < 5; i++) trigger_event_by_id(em, EVENT_USER_LOGIN, &user1);
+    for (int i = 0; i < 2; i++) trigger_event_by_id(em, EVENT_USER_LOGIN, &user2);
+    usleep(25000);
+    flush_coalesced_events(em, 0); // both windows are over: one dispatch per user
+    print_coalesce_stats(em);
+
+    // which module costs how much of each event (and a timeline for chrome://tracing / Perfetto)
+    stop_tracing(em);
+    print_trace_stats(em);
+    dump_trace_json(em, "event_trace.json");
+
+    destroy_manager(em);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,333 @@
+// Cross-process event bus over shared memory (header only, included by event_manager.h)
+// One shared region holds a ring buffer per out-of-process subscriber: publishers copy the
+// event's context into a fixed size slot of every subscribed ring (one memcpy per subscriber,
+// no sockets, no syscalls while the reader is busy), the reader process pops messages from
+// its own ring and sleeps on a futex word in the region when it runs dry.
+//
+// Region: memfd (anonymous, inherited by fork() / passable over a unix socket) or a POSIX
+// shm_open() name that unrelated processes can open. Rings are Vyukov style MPSC rings with
+// sequence numbered slots, so any number of publishers (threads or processes) may publish;
+// each ring has exactly one reader. A full ring drops the message (counted), a slow or dead
+// subscriber process never blocks the publisher.
+#ifndef EVENT_SHM_BUS_H
+#define EVENT_SHM_BUS_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE // memfd_create()
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SHM_BUS_MAGIC 0x53425645u     // "EVBS"
+#define SHM_BUS_MAX_RINGS 16          // out-of-process subscribers per bus
+#define SHM_BUS_MAX_EVENTS 64         // event ids 0..63 (subscriptions are a 64 bit mask)
+#define SHM_BUS_SLOT_BYTES 256        // one message: header + context
+#define SHM_BUS_MAX_CONTEXT (SHM_BUS_SLOT_BYTES - 16)
+
+typedef struct {
+    _Atomic uint64_t seq;  // == position + 1 once the message is written, position + slots once read
+    int32_t eventId;
+    uint32_t size;         // context bytes
+    unsigned char data[SHM_BUS_MAX_CONTEXT];
+} ShmSlot;
+
+typedef struct {
+    _Alignas(64) _Atomic uint32_t state; // SHM_RING_FREE / _CLAIMED / _ACTIVE / _CLOSING
+    _Atomic uint64_t events;             // bit per subscribed event id
+    char name[32];                       // subscriber, for stats
+    uint64_t slotsOffset;                // from the start of the region
+    _Alignas(64) _Atomic uint64_t enqueuePos; // publishers
+    _Atomic uint32_t publishers;              // between their 'events' check and their commit
+    _Atomic uint64_t published, dropped;
+    _Alignas(64) _Atomic uint64_t dequeuePos; // the reader
+    _Atomic uint32_t sleeping;           // futex word: 1 while the reader waits for messages
+} ShmRing;
+
+enum { SHM_RING_FREE, SHM_RING_CLAIMED, SHM_RING_ACTIVE, SHM_RING_CLOSING }; // CLOSING: unsubscribed, reader draining
+
+typedef struct {
+    uint32_t magic;
+    uint32_t slotsPerRing; // power of 2
+    uint64_t regionBytes;
+    char eventNames[SHM_BUS_MAX_EVENTS][50]; // written by the publisher, so readers get names too
+    ShmRing rings[SHM_BUS_MAX_RINGS];
+} ShmBusRegion;
+
+typedef struct {
+    ShmBusRegion* region;
+    int fd;
+    char shmName[64]; // "" for memfd
+} ShmBus;
+
+// process-shared futex (no FUTEX_PRIVATE_FLAG): waiters and wakers live in different processes
+static inline void shm_futex_wait(_Atomic uint32_t* addr, uint32_t val, const struct timespec* timeout) {
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, timeout, NULL, 0);
+}
+
+static inline void shm_futex_wake(_Atomic uint32_t* addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static inline ShmSlot* shm_ring_slot(ShmBus* bus, ShmRing* ring, uint64_t pos) {
+    return (ShmSlot*)((char*)bus->region + ring->slotsOffset) + (pos & (bus->region->slotsPerRing - 1));
+}
+
+static ShmBus* shm_bus_map(int fd, size_t bytes, const char* shmName) {
+    ShmBus* bus = (ShmBus*)calloc(1, sizeof(ShmBus));
+    if (bus == NULL) {
+        perror("shm_bus_map");
+        return NULL;
+    }
+    bus->region = (ShmBusRegion*)mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (bus->region == MAP_FAILED) {
+        perror("shm_bus_map: mmap");
+        free(bus);
+        return NULL;
+    }
+    bus->fd = fd;
+    if (shmName != NULL) snprintf(bus->shmName, sizeof(bus->shmName), "%s", shmName);
+    return bus;
+}
+
+// Create a bus with 'slotsPerRing' (rounded up to a power of 2) messages per subscriber.
+// shmName NULL => anonymous memfd, shared with children forked afterwards;
+// else a shm_open() name like "/event_bus" that other processes shm_bus_open().
+ShmBus* shm_bus_create(const char* shmName, uint32_t slotsPerRing) {
+    uint32_t slots = 2;
+    while (slots < slotsPerRing) slots <<= 1;
+    size_t header = (sizeof(ShmBusRegion) + 63) & ~(size_t)63;
+    size_t bytes = header + (size_t)SHM_BUS_MAX_RINGS * slots * sizeof(ShmSlot);
+
+    int fd = shmName ? shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0600) : memfd_create("event_bus", 0);
+    if (fd < 0) {
+        perror("shm_bus_create");
+        return NULL;
+    }
+    if (ftruncate(fd, bytes) < 0) { // zero filled
+        perror("shm_bus_create: ftruncate");
+        close(fd);
+        if (shmName) shm_unlink(shmName);
+        return NULL;
+    }
+    ShmBus* bus = shm_bus_map(fd, bytes, shmName);
+    if (bus == NULL) {
+        close(fd);
+        if (shmName) shm_unlink(shmName);
+        return NULL;
+    }
+    ShmBusRegion* r = bus->region;
+    r->slotsPerRing = slots;
+    r->regionBytes = bytes;
+    for (int i = 0; i < SHM_BUS_MAX_RINGS; i++) {
+        r->rings[i].slotsOffset = header + (size_t)i * slots * sizeof(ShmSlot);
+        ShmSlot* s = (ShmSlot*)((char*)r + r->rings[i].slotsOffset);
+        for (uint32_t k = 0; k < slots; k++) atomic_init(&s[k].seq, k);
+    }
+    r->magic = SHM_BUS_MAGIC; // last: shm_bus_open() checks it
+    return bus;
+}
+
+// Map a bus another process created with shm_bus_create("/name", ...)
+ShmBus* shm_bus_open(const char* shmName) {
+    int fd = shm_open(shmName, O_RDWR, 0);
+    if (fd < 0) {
+        perror("shm_bus_open");
+        return NULL;
+    }
+    ShmBusRegion head;
+    if (pread(fd, &head, sizeof(head.magic) + sizeof(head.slotsPerRing) + sizeof(head.regionBytes), 0) <= 0 ||
+        head.magic != SHM_BUS_MAGIC) {
+        fprintf(stderr, "shm_bus_open: %s is not an event bus\n", shmName);
+        close(fd);
+        return NULL;
+    }
+    ShmBus* bus = shm_bus_map(fd, head.regionBytes, NULL); // shmName stays "": only the creator unlinks
+    if (bus == NULL) close(fd);
+    return bus;
+}
+
+void shm_bus_close(ShmBus* bus) {
+    if (bus == NULL) return;
+    munmap(bus->region, bus->region->regionBytes);
+    close(bus->fd);
+    if (bus->shmName[0] != '\0') shm_unlink(bus->shmName);
+    free(bus);
+}
+
+// Claim a ring for a subscriber of the events in 'eventMask' (bit i = event id i).
+// Any process may claim it (e.g. the parent before fork()); exactly one process reads it,
+// and a ring is only claimed again once its previous reader has stopped.
+// Returns the ring index, -1 if all rings are taken.
+int shm_bus_subscribe(ShmBus* bus, const char* name, uint64_t eventMask) {
+    for (int i = 0; i < SHM_BUS_MAX_RINGS; i++) {
+        ShmRing* ring = &bus->region->rings[i];
+        uint32_t expected = SHM_RING_FREE;
+        if (!atomic_compare_exchange_strong(&ring->state, &expected, SHM_RING_CLAIMED)) continue;
+        // skip what a previous subscriber of this ring left unread
+        uint64_t pos = atomic_load(&ring->dequeuePos);
+        for (;; pos++) {
+            ShmSlot* slot = shm_ring_slot(bus, ring, pos);
+            if (atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1) break;
+            atomic_store_explicit(&slot->seq, pos + bus->region->slotsPerRing, memory_order_release);
+        }
+        atomic_store(&ring->dequeuePos, pos);
+        snprintf(ring->name, sizeof(ring->name), "%s", name);
+        atomic_store(&ring->published, 0);
+        atomic_store(&ring->dropped, 0);
+        atomic_store(&ring->events, eventMask);
+        atomic_store(&ring->state, SHM_RING_ACTIVE);
+        return i;
+    }
+    fprintf(stderr, "shm_bus_subscribe: all %d rings in use\n", SHM_BUS_MAX_RINGS);
+    return -1;
+}
+
+// Stop publishing to the ring; its reader still gets what is queued, then shm_bus_receive() returns -2.
+// The ring stays CLOSING until then: only the reader hands it back (FREE) for a new subscriber.
+void shm_bus_unsubscribe(ShmBus* bus, int ringId) {
+    ShmRing* ring = &bus->region->rings[ringId];
+    atomic_store(&ring->events, 0);
+    uint32_t expected = SHM_RING_ACTIVE;
+    atomic_compare_exchange_strong(&ring->state, &expected, SHM_RING_CLOSING);
+    if (atomic_exchange(&ring->sleeping, 0)) shm_futex_wake(&ring->sleeping);
+}
+
+// Copy the message into every ring subscribed to 'eventId'; returns the number of rings reached
+int shm_bus_publish(ShmBus* bus, int eventId, const void* context, uint32_t size) {
+    if (eventId < 0 || eventId >= SHM_BUS_MAX_EVENTS || size > SHM_BUS_MAX_CONTEXT) return 0;
+    uint64_t bit = 1ULL << eventId;
+    int delivered = 0;
+    for (int i = 0; i < SHM_BUS_MAX_RINGS; i++) {
+        ShmRing* ring = &bus->region->rings[i];
+        if (!(atomic_load_explicit(&ring->events, memory_order_relaxed) & bit)) continue;
+        // announce ourselves before the real mask check, so a closing reader waits for our commit
+        atomic_fetch_add(&ring->publishers, 1);
+        if (!(atomic_load(&ring->events) & bit)) {
+            atomic_fetch_sub(&ring->publishers, 1);
+            continue;
+        }
+
+        uint64_t pos = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+        ShmSlot* slot;
+        for (;;) {
+            slot = shm_ring_slot(bus, ring, pos);
+            int64_t diff = (int64_t)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (atomic_compare_exchange_weak_explicit(&ring->enqueuePos, &pos, pos + 1,
+                                                          memory_order_relaxed, memory_order_relaxed)) break;
+            }
+            else if (diff < 0) { slot = NULL; break; } // full
+            else pos = atomic_load_explicit(&ring->enqueuePos, memory_order_relaxed);
+        }
+        if (slot == NULL) {
+            atomic_fetch_sub(&ring->publishers, 1);
+            atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+            continue;
+        }
+        slot->eventId = eventId;
+        slot->size = size;
+        if (size) memcpy(slot->data, context, size);
+        atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+        atomic_fetch_sub(&ring->publishers, 1);
+        atomic_fetch_add_explicit(&ring->published, 1, memory_order_relaxed);
+        delivered++;
+
+        // message stored before 'sleeping' is read; pairs with the fence in shm_bus_receive()
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&ring->sleeping, memory_order_relaxed) && atomic_exchange(&ring->sleeping, 0))
+            shm_futex_wake(&ring->sleeping);
+    }
+    return delivered;
+}
+
+// Reader side: next message of the ring, copied into 'buf' (at most bufSize bytes).
+// Waits up to timeoutMs (-1 = forever). Returns the context size, -1 on timeout,
+// -2 once the ring was unsubscribed and everything queued was read.
+int shm_bus_receive(ShmBus* bus, int ringId, int* eventId, void* buf, uint32_t bufSize, int timeoutMs) {
+    ShmRing* ring = &bus->region->rings[ringId];
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeoutMs / 1000;
+    deadline.tv_nsec += (long)(timeoutMs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) { deadline.tv_sec++; deadline.tv_nsec -= 1000000000; }
+
+    uint64_t pos = atomic_load_explicit(&ring->dequeuePos, memory_order_relaxed); // single reader
+    ShmSlot* slot = shm_ring_slot(bus, ring, pos);
+    for (;;) {
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1) break;
+        uint32_t state = atomic_load(&ring->state);
+        if (state == SHM_RING_CLOSING) {
+            // drained only once no publisher that saw the old mask is still on its way in (it would
+            // commit into a ring handed to the next subscriber) and every reserved slot was read
+            if (atomic_load(&ring->publishers) == 0 && atomic_load(&ring->enqueuePos) == pos) {
+                atomic_compare_exchange_strong(&ring->state, &state, SHM_RING_FREE);
+                return -2;
+            }
+            sched_yield(); // a memcpy away
+            continue;
+        }
+        if (state == SHM_RING_FREE) return -2;
+
+        atomic_store_explicit(&ring->sleeping, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire) == pos + 1) { // raced with a publisher
+            atomic_store(&ring->sleeping, 0);
+            break;
+        }
+        if (atomic_load(&ring->state) != SHM_RING_ACTIVE) { // unsubscribed meanwhile
+            atomic_store(&ring->sleeping, 0);
+            continue;
+        }
+        if (timeoutMs < 0) {
+            shm_futex_wait(&ring->sleeping, 1, NULL);
+        }
+        else {
+            struct timespec now, left;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec = deadline.tv_sec - now.tv_sec;
+            left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) { left.tv_sec--; left.tv_nsec += 1000000000; }
+            if (left.tv_sec < 0) {
+                atomic_store(&ring->sleeping, 0);
+                return -1;
+            }
+            shm_futex_wait(&ring->sleeping, 1, &left);
+        }
+    }
+
+    uint32_t size = slot->size < bufSize ? slot->size : bufSize;
+    *eventId = slot->eventId;
+    if (size) memcpy(buf, slot->data, size);
+    atomic_store_explicit(&slot->seq, pos + bus->region->slotsPerRing, memory_order_release); // slot free again
+    atomic_store_explicit(&ring->dequeuePos, pos + 1, memory_order_relaxed);
+    return (int)size;
+}
+
+// Name of an event as published into the region (readers in other processes use it)
+const char* shm_bus_event_name(ShmBus* bus, int eventId) {
+    if (eventId < 0 || eventId >= SHM_BUS_MAX_EVENTS) return "";
+    return bus->region->eventNames[eventId];
+}
+
+void print_shm_bus_stats(ShmBus* bus) {
+    printf("[ShmBus] %-10s %-20s %10s %10s %8s\n", "RING", "SUBSCRIBER", "PUBLISHED", "DROPPED", "QUEUED");
+    for (int i = 0; i < SHM_BUS_MAX_RINGS; i++) {
+        ShmRing* ring = &bus->region->rings[i];
+        if (ring->name[0] == '\0') continue;
+        printf("[ShmBus] %-10d %-20s %10llu %10llu %8llu\n", i, ring->name,
+               (unsigned long long)atomic_load(&ring->published), (unsigned long long)atomic_load(&ring->dropped),
+               (unsigned long long)(atomic_load(&ring->enqueuePos) - atomic_load(&ring->dequeuePos)));
+    }
+}
+
+#endif